@@ -222,11 +222,15 @@ void (* const g_pfnVectors[])(void) =
 // The following are constructs created by the linker, indicating where the
 // the "data" and "bss" segments reside in memory.  The initializers for the
 // for the "data" segment resides immediately following the "text" segment.
+// The code for the "ramfunc" segment follows the "data" initializers.
 //
 //*****************************************************************************
 extern uint32_t _ldata;
 extern uint32_t _data;
 extern uint32_t _edata;
+extern uint32_t _lramfunc;
+extern uint32_t _ramfunc;
+extern uint32_t _eramfunc;
 extern uint32_t _bss;
 extern uint32_t _ebss;
 
@@ -254,6 +258,15 @@ ResetISR(void)
         *pui32Dest++ = *pui32Src++;
     }
 
+    //
+    // Copy the code that runs from SRAM out of flash.
+    //
+    pui32Src = &_lramfunc;
+    for(pui32Dest = &_ramfunc; pui32Dest < &_eramfunc; )
+    {
+        *pui32Dest++ = *pui32Src++;
+    }
+
     //
     // Zero fill the bss segment.
     //
@@ -46,6 +46,99 @@ enum OpenEEPROM_SpiMode {
     OPEN_EEPROM_SPI_MODE_3 = 8,
 };
 
+/**
+ * @enum OpenEEPROM_WriteMode
+ *
+ * Flags controlling how write commands
+ * program an attached memory IC.
+ */
+enum OpenEEPROM_WriteMode {
+    OPEN_EEPROM_WRITE_MODE_NORMAL = 0,
+    OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED = 1,
+    OPEN_EEPROM_WRITE_MODE_VERIFY = 2,
+};
+
+/**
+ * @enum OpenEEPROM_ChecksumType
+ *
+ * Checksums that can be computed over a range of memory.
+ */
+enum OpenEEPROM_ChecksumType {
+    OPEN_EEPROM_CHECKSUM_CRC32,
+    OPEN_EEPROM_CHECKSUM_CRC16,
+    OPEN_EEPROM_CHECKSUM_SUM,
+};
+
+/**
+ * @enum OpenEEPROM_PadDrive
+ *
+ * Drive strength, and slew rate control, of 
+ * the programmer pins on the parallel bus.
+ * Not all may be supported by a programmer.
+ */
+enum OpenEEPROM_PadDrive {
+    OPEN_EEPROM_PAD_DRIVE_2MA,
+    OPEN_EEPROM_PAD_DRIVE_4MA,
+    OPEN_EEPROM_PAD_DRIVE_8MA,
+    OPEN_EEPROM_PAD_DRIVE_8MA_SLEW_CONTROL,
+};
+
+/**
+ * @enum OpenEEPROM_EpromPulseLine
+ *
+ * Control line that carries the program pulse of a UV EPROM.
+ * Smaller parts such as the 27C64-27C256 are pulsed on CE#,
+ * larger ones hold CE# low and are pulsed on a separate PGM#.
+ */
+enum OpenEEPROM_EpromPulseLine {
+    OPEN_EEPROM_EPROM_PULSE_CE,
+    OPEN_EEPROM_EPROM_PULSE_PGM,
+};
+
+/**
+ * @enum OpenEEPROM_JobType
+ *
+ * Long-running operations that run as a background job.
+ */
+enum OpenEEPROM_JobType {
+    OPEN_EEPROM_JOB_CHIP_ERASE,
+    OPEN_EEPROM_JOB_CHECKSUM,
+    OPEN_EEPROM_JOB_VERIFY,
+    OPEN_EEPROM_JOB_PROGRAM_IMAGE,
+    OPEN_EEPROM_JOB_UPDATE_IMAGE,
+};
+
+/**
+ * @enum OpenEEPROM_JobState
+ *
+ * State of the most recent background job.
+ */
+enum OpenEEPROM_JobState {
+    OPEN_EEPROM_JOB_STATE_IDLE,
+    OPEN_EEPROM_JOB_STATE_RUNNING,
+    OPEN_EEPROM_JOB_STATE_DONE,
+    OPEN_EEPROM_JOB_STATE_FAILED,
+    OPEN_EEPROM_JOB_STATE_ABORTED,
+};
+
+/**
+ * @struct OpenEEPROM_ParallelTiming
+ *
+ * Parallel bus timings in nanoseconds, in the 
+ * order @ref OpenEEPROM_setParallelTiming takes them.
+ * A timing of 0 adds no delay at all.
+ */
+struct OpenEEPROM_ParallelTiming {
+    uint32_t addressSetup;      /**< tAS: address valid before a write pulse */
+    uint32_t addressHold;       /**< tAH: address held after a write pulse starts */
+    uint32_t dataSetup;         /**< tDS: data valid before a write pulse ends */
+    uint32_t dataHold;          /**< tDH: data held after a write pulse ends */
+    uint32_t addressAccess;     /**< tACC: address valid to output data valid */
+    uint32_t outputEnable;      /**< tOE: output enable to output data valid */
+    uint32_t writePulse;        /**< tWP: write pulse width */
+    uint32_t writePulseHigh;    /**< tWPH: time between write pulses */
+};
+
 /**
  * @enum OpenEEPROM_Command
  *
@@ -68,6 +161,37 @@ enum OpenEEPROM_Command {
     OPEN_EEPROM_CMD_SET_SPI_MODE,
     OPEN_EEPROM_CMD_GET_SUPPORTED_SPI_MODES,
     OPEN_EEPROM_CMD_SPI_TRANSMIT,
+    OPEN_EEPROM_CMD_SET_WRITE_MODE,
+    OPEN_EEPROM_CMD_SET_PAGE_SIZE,
+    OPEN_EEPROM_CMD_SPI_WRITE,
+    OPEN_EEPROM_CMD_CHECKSUM,
+    OPEN_EEPROM_CMD_SET_I2C_ADDRESS,
+    OPEN_EEPROM_CMD_BLANK_CHECK,
+    OPEN_EEPROM_CMD_BLOCK_HASHES,
+    OPEN_EEPROM_CMD_SET_WRITE_RETRIES,
+    OPEN_EEPROM_CMD_SAVE_PROFILE,
+    OPEN_EEPROM_CMD_LIST_PROFILES,
+    OPEN_EEPROM_CMD_APPLY_PROFILE,
+    OPEN_EEPROM_CMD_IDENTIFY,
+    OPEN_EEPROM_CMD_CALIBRATE_ADDRESS_HOLD_TIME,
+    OPEN_EEPROM_CMD_SET_PARALLEL_TIMING,
+    OPEN_EEPROM_CMD_SET_DATA_BUS_WIDTH,
+    OPEN_EEPROM_CMD_SET_PAGE_READ,
+    OPEN_EEPROM_CMD_SET_EPROM_PROGRAMMING,
+    OPEN_EEPROM_CMD_EPROM_PROGRAM,
+    OPEN_EEPROM_CMD_START_JOB,
+    OPEN_EEPROM_CMD_JOB_STATUS,
+    OPEN_EEPROM_CMD_JOB_ABORT,
+    OPEN_EEPROM_CMD_IMAGE_BEGIN,
+    OPEN_EEPROM_CMD_IMAGE_WRITE,
+    OPEN_EEPROM_CMD_IMAGE_END,
+    OPEN_EEPROM_CMD_SET_STANDALONE,
+    OPEN_EEPROM_CMD_COPY,
+    OPEN_EEPROM_CMD_FILL,
+    OPEN_EEPROM_CMD_READ_EXTENTS,
+    OPEN_EEPROM_CMD_WRITE_EXTENTS,
+    OPEN_EEPROM_CMD_WRITE_BUFFERED,
+    OPEN_EEPROM_CMD_FLUSH_WRITES,
 };
 
 extern const uint8_t OpenEEPROM_ACK;
@@ -82,19 +206,55 @@ int OpenEEPROM_getSupportedBusTypes(const char *in, char *out);
 int OpenEEPROM_getMaxRxSize(const char *in, char *out);
 int OpenEEPROM_getMaxTxSize(const char *in, char *out);
 int OpenEEPROM_toggleIO(const char *in, char *out);
+int OpenEEPROM_setWriteMode(const char *in, char *out);
+int OpenEEPROM_setPageSize(const char *in, char *out);
+int OpenEEPROM_checksum(const char *in, char *out);
+int OpenEEPROM_blankCheck(const char *in, char *out);
+int OpenEEPROM_blockHashes(const char *in, char *out);
+int OpenEEPROM_saveProfile(const char *in, char *out);
+int OpenEEPROM_listProfiles(const char *in, char *out);
+int OpenEEPROM_applyProfile(const char *in, char *out);
+int OpenEEPROM_identify(const char *in, char *out);
+int OpenEEPROM_startJob(const char *in, char *out);
+int OpenEEPROM_jobStatus(const char *in, char *out);
+int OpenEEPROM_jobAbort(const char *in, char *out);
+int OpenEEPROM_imageBegin(const char *in, char *out);
+int OpenEEPROM_imageWrite(const char *in, char *out);
+int OpenEEPROM_imageEnd(const char *in, char *out);
+int OpenEEPROM_setStandalone(const char *in, char *out);
+int OpenEEPROM_copy(const char *in, char *out);
+int OpenEEPROM_fill(const char *in, char *out);
+int OpenEEPROM_readExtents(const char *in, char *out);
+int OpenEEPROM_writeExtents(const char *in, char *out);
+int OpenEEPROM_writeBuffered(const char *in, char *out);
+int OpenEEPROM_flushWrites(const char *in, char *out);
+void OpenEEPROM_drainWrites(void);
+int OpenEEPROM_jobRunning(void);
+int OpenEEPROM_jobTick(void);
 
 /* Parallel Commands */
 int OpenEEPROM_setAddressBusWidth(const char *in, char *out);
+int OpenEEPROM_setDataBusWidth(const char *in, char *out);
 int OpenEEPROM_setAddressHoldTime(const char *in, char *out);
+int OpenEEPROM_calibrateAddressHoldTime(const char *in, char *out);
 int OpenEEPROM_setAddressPulseWidthTime(const char *in, char *out);
+int OpenEEPROM_setParallelTiming(const char *in, char *out);
+int OpenEEPROM_setPageRead(const char *in, char *out);
+int OpenEEPROM_setWriteRetries(const char *in, char *out);
 int OpenEEPROM_parallelRead(const char *in, char *out);
 int OpenEEPROM_parallelWrite(const char *in, char *out);
+int OpenEEPROM_setEpromProgramming(const char *in, char *out);
+int OpenEEPROM_epromProgram(const char *in, char *out);
 
 /* SPI Commands */
 int OpenEEPROM_setSpiFrequency(const char *in, char *out);
 int OpenEEPROM_setSpiMode(const char *in, char *out);
 int OpenEEPROM_getSupportedSpiModes(const char *in, char *out);
 int OpenEEPROM_spiTransmit(const char *in, char *out);
+int OpenEEPROM_spiWrite(const char *in, char *out);
+
+/* I2C Commands */
+int OpenEEPROM_setI2cAddress(const char *in, char *out);
 
 #endif /* __OPEN_EEPROM_H__ */
 
@@ -4,8 +4,72 @@
 #include "open-eeprom.h"
 
 #define OPEN_EEPROM_VERSION_NUMBER        0x01
-#define OPEN_EEPROM_SUPPORTED_BUS_TYPES   OPEN_EEPROM_BUS_MODE_PARALLEL | OPEN_EEPROM_BUS_MODE_SPI;  
+#define OPEN_EEPROM_SUPPORTED_BUS_TYPES   (OPEN_EEPROM_BUS_MODE_PARALLEL | OPEN_EEPROM_BUS_MODE_SPI | OPEN_EEPROM_BUS_MODE_I2C)
 
+/* Bytes of the transfer arena kept back from the largest request and 
+   response, enough for any fixed-size header or response beside them. */
+#define OPEN_EEPROM_FRAME_RESERVE         128
+
+/* Largest page, in bytes, that write commands will program at once. */
+#define OPEN_EEPROM_PAGE_BUFFER_SIZE      256
+
+/* Bytes used to address a serial flash after the instruction byte. */
+#define OPEN_EEPROM_SPI_ADDRESS_BYTES     3
+
+/* Most failing addresses a verified write reports back. */
+#define OPEN_EEPROM_MAX_REPORTED_FAILURES 16
+
+/* Default 7-bit address of an I2C memory and the bytes used
+   to address a location inside it (24C01-24C16 use one). */
+#define OPEN_EEPROM_I2C_DEFAULT_ADDRESS       0x50
+#define OPEN_EEPROM_I2C_DEFAULT_ADDRESS_BYTES 2
+
+/* Longest internal write cycle to wait for before giving up, and how 
+   often to poll the chip while waiting, both in nanoseconds. */
+#define OPEN_EEPROM_WRITE_CYCLE_TIMEOUT   10000000
+#define OPEN_EEPROM_WRITE_POLL_INTERVAL   1000
+
+/* Chip profiles kept in the programmer's non-volatile storage, 
+   and the size of the name stored with each. */
+#define OPEN_EEPROM_PROFILE_COUNT         16
+#define OPEN_EEPROM_PROFILE_NAME_SIZE     16
+
+/* Conservative settings used while probing for an unknown chip, in
+   nanoseconds and Hz, and the fastest SPI clock the programmer drives
+   an identified chip at, whatever its rating. */
+#define OPEN_EEPROM_PROBE_ACCESS_TIME     500
+#define OPEN_EEPROM_PROBE_PULSE_WIDTH     500
+#define OPEN_EEPROM_PROBE_SPI_FREQ        1000000
+#define OPEN_EEPROM_MAX_SPI_FREQ          20000000
+
+/* Times a sample range must read back unchanged for an address
+   hold time to count as stable during calibration. */
+#define OPEN_EEPROM_CALIBRATION_PASSES    8
+
+/* Default EPROM quick-pulse programming: width of each program pulse 
+   in nanoseconds, pulses tried before a byte counts as failed, and the
+   final overprogram pulse as a multiple of the pulses the byte needed. 
+   Vpp is given time to settle after it is switched on. */
+#define OPEN_EEPROM_EPROM_PULSE_WIDTH     100000
+#define OPEN_EEPROM_EPROM_MAX_PULSES      25
+#define OPEN_EEPROM_EPROM_OVERPROGRAM     3
+#define OPEN_EEPROM_VPP_SETTLE_TIME       1000000
+
+/* Longest a background chip erase may take, in milliseconds. */
+#define OPEN_EEPROM_CHIP_ERASE_TIMEOUT    200000
+
+/* Longest a 4 KB serial flash sector erase may take, in milliseconds. */
+#define OPEN_EEPROM_SECTOR_ERASE_TIMEOUT  2000
+
+/* Longest a buffered write waits for the rest of its page, in milliseconds. */
+#define OPEN_EEPROM_WRITE_COALESCE_TIMEOUT 50
+
+/* Placement of the inner parallel read and write loops. By default they
+   go in the .ramfunc section, which the startup code copies to SRAM so 
+   they run without flash wait states. Define as empty to keep them in flash. */
+#ifndef OPEN_EEPROM_RAMFUNC
+#define OPEN_EEPROM_RAMFUNC __attribute__((section(".ramfunc"), long_call, noinline))
+#endif
 
 #endif /* __OPEN_EEPROM_CONF_H__ */
 
@@ -3,7 +3,7 @@
 
 #include <stddef.h>
 
-int OpenEEPROM_serverInit(char *rxbuf, size_t maxRxSize, char *txbuf, size_t maxTxSize);
+int OpenEEPROM_serverInit(char *arena, size_t arenaSize);
 int OpenEEPROM_serverTick(void);
 
 #endif /* __OPEN_EEPROM_SERVER_H__ */
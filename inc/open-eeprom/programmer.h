@@ -19,6 +19,13 @@
  */
 extern const uint32_t Programmer_MinimumDelay;
 
+/**
+ * @brief Rate, in ticks per second, of @ref Programmer_getTicks.
+ *
+ * Must be a multiple of 1000 so that ticks convert to milliseconds.
+ */
+extern const uint32_t Programmer_TicksPerSecond;
+
 /**
  * @brief Initialize the programmer.
  *
@@ -50,6 +57,15 @@ int Programmer_initParallel(void);
  */
 int Programmer_initSpi(void);
 
+/**
+ * @brief Initialize the I2C peripheral
+ *      and related GPIO pins.
+ *
+ * After this function runs, all I2C transfer functionality 
+ * should be enabled with the programmer acting as the bus master.
+ */
+int Programmer_initI2c(void);
+
 /**
  * @brief Disable all connected IO pins.
  *
@@ -80,6 +96,67 @@ int Programmer_toggleDataIOMode(uint8_t mode);
  */
 int Programmer_getAddressPinCount(void);
 
+/**
+ * @brief Get the number of address bits an external
+ *      address extender adds to the bus.
+ *
+ * Parts larger than the native address lines can reach
+ * take their upper address bits from shift register
+ * latches, such as 74HC595s, clocked by the programmer.
+ *
+ * @return extender width, or 0 if there is no extender
+ */
+int Programmer_getAddressExtenderWidth(void);
+
+/**
+ * @brief Select whether the address extender is used.
+ *
+ * The extender may take over some native address pins,
+ * so this returns how many remain. The pins are set up
+ * by the next call to @ref Programmer_initParallel.
+ *
+ * @param enable 0 to drive every address line natively,
+ *      else drive the upper address bits through the extender
+ *
+ * @return number of native address lines, or 0 if the
+ *      extender is not supported
+ */
+int Programmer_setAddressExtender(uint8_t enable);
+
+/**
+ * @brief Latch the upper address bits into the extender.
+ *
+ * The bits stay on the extender outputs until the next
+ * call, so sequential accesses only need this when they
+ * cross into the next block of native addresses.
+ *
+ * @param address address bits above the native address lines
+ */
+int Programmer_setUpperAddress(uint32_t address);
+
+/**
+ * @brief Get the number of data pins 
+ *      supported by the programmer.
+ *
+ * @return total width of the data bus, 8 or 16
+ */
+int Programmer_getDataPinCount(void);
+
+/**
+ * @brief Set how many data lines are used.
+ *
+ * Word-wide parts use all 16 data lines, byte-wide
+ * parts only D7:D0. The width applies to 
+ * @ref Programmer_setData, @ref Programmer_getData and
+ * @ref Programmer_toggleDataIOMode; unused lines are 
+ * left as inputs.
+ *
+ * @param busWidth 8 or 16
+ *
+ * @return 1 if the width is supported, else 0
+ */
+int Programmer_setDataBusWidth(uint8_t busWidth);
+
 /**
  * @brief Set the value outputted onto the address bus.
  *
@@ -96,11 +173,12 @@ int Programmer_setAddress(uint8_t busWidth, uint32_t address);
 /**
  * @brief Set the value outputted on the data bus.
  *
- * Currently only a fixed 8-bit data bus is supported.
+ * Only the lines selected by @ref Programmer_setDataBusWidth
+ * are driven.
  *
- * @param data value to output on the bus
+ * @param data value to output on the bus, [D15:D0]
  */
-int Programmer_setData(uint8_t data);
+int Programmer_setData(uint16_t data);
 
 /**
  * @brief Read the values on the data bus.
@@ -109,9 +187,10 @@ int Programmer_setData(uint8_t data);
  * as inputs. It should simply read the values currently being inputted
  * into each of the data lines.
  *
- * @return the value being inputted into the data lines, [D7:D0]
+ * @return the value being inputted into the data lines, 
+ *      [D7:D0] or [D15:D0] depending on the bus width
  */
-uint8_t Programmer_getData(void);
+uint16_t Programmer_getData(void);
 
 /**
  * @brief Toggle the IO line that serves as the CE control line.
@@ -134,6 +213,31 @@ int Programmer_toggleOE(uint8_t state);
  */
 int Programmer_toggleWE(uint8_t state);
 
+/**
+ * @brief Toggle the IO line that serves as the PGM# line of an EPROM.
+ *
+ * Programmers may share this line with another control line, 
+ * such as WE, since they are not used at the same time.
+ *
+ * @param state 0 set the line low, else set the line high
+ */
+int Programmer_togglePGM(uint8_t state);
+
+/**
+ * @brief Switch the EPROM programming voltage on or off.
+ *
+ * The programmer only enables the external Vpp supply, which 
+ * must be set to the voltage the EPROM specifies. Vpp should 
+ * be off after @ref Programmer_init and whenever the IO pins 
+ * are disabled.
+ *
+ * @param enable 0 to switch Vpp off, else on
+ *
+ * @return 1 if successful, or 0 if the programmer 
+ *      cannot switch Vpp
+ */
+int Programmer_setVpp(uint8_t enable);
+
 /**
  * @brief Wait for `delay` nanoseconds.
  *
@@ -145,6 +249,59 @@ int Programmer_toggleWE(uint8_t state);
  */
 int Programmer_delay1ns(uint32_t delay);
 
+/**
+ * @brief Get the value of a free-running tick counter.
+ *
+ * The counter counts up at @ref Programmer_TicksPerSecond
+ * and wraps around at 2^32, so intervals are measured
+ * as the unsigned difference of two readings.
+ *
+ * @return current tick count
+ */
+uint32_t Programmer_getTicks(void);
+
+/**
+ * @brief Start a deadline `delay` nanoseconds from now.
+ *
+ * Unlike @ref Programmer_delay1ns this returns at once, so
+ * the caller can do useful work until it calls 
+ * @ref Programmer_waitDelay. The same rounding rules apply.
+ *
+ * @param delay nanoseconds until the deadline
+ */
+void Programmer_startDelay(uint32_t delay);
+
+/**
+ * @brief Wait until the deadline of the last
+ *      @ref Programmer_startDelay has passed.
+ */
+void Programmer_waitDelay(void);
+
+/**
+ * @brief Prepare the address and data of a parallel write.
+ *
+ * The pin values for the whole bus are computed ahead of 
+ * time, so that @ref Programmer_commitWrite only has to 
+ * output them. Staging does not change any outputs, which 
+ * lets the next write be prepared while a write pulse for 
+ * the current one is running.
+ *
+ * @param busWidth max bits to use from `address`
+ *
+ * @param address value for the address bus, as for 
+ *      @ref Programmer_setAddress
+ *
+ * @param data value for the data bus, as for
+ *      @ref Programmer_setData
+ */
+void Programmer_stageWrite(uint8_t busWidth, uint32_t address, uint16_t data);
+
+/**
+ * @brief Output the address and data staged by 
+ *      @ref Programmer_stageWrite.
+ */
+void Programmer_commitWrite(void);
+
 /**
  * @brief Set the clock frequency of the SPI peripheral. 
  *
@@ -166,7 +323,7 @@ uint32_t Programmer_getSpiClockFreq(void);
  * 
  * The programmer is only required to support mode 0. 
  *
- * @param mode desired SPI mode
+ * @param mode desired @ref OpenEEPROM_SpiMode
  *
  * @return 1 if SPI mode is set, or 0 if desired mode is not supported
  */
@@ -197,6 +354,10 @@ uint8_t Programmer_getSupportedSpiModes(void);
  * at the end.
  *
  * Both txbuf and rxbuf should be at least the size of `count`.
+ * They may also be the same buffer, in which case each received 
+ * byte overwrites the transmitted byte it was exchanged for. 
+ * Implementations must therefore read `txbuf[i]` before writing 
+ * `rxbuf[i]` and never write ahead of the byte being transmitted.
  *
  * @param txbuf buffer of bytes to transmit
  *
@@ -206,5 +367,195 @@ uint8_t Programmer_getSupportedSpiModes(void);
  */
 int Programmer_spiTransmit(const char *txbuf, char *rxbuf, size_t count);
 
+/**
+ * @brief Write and then read bytes from an I2C device.
+ *
+ * If `txCount` is nonzero, a start condition and the device
+ * address with the write bit are sent, followed by `txCount` 
+ * bytes from `txbuf`. If `rxCount` is nonzero, a (repeated) 
+ * start and the device address with the read bit follow, and 
+ * `rxCount` bytes are read into `rxbuf`, acknowledging all but 
+ * the last. The transfer always ends with a stop condition.
+ *
+ * @param address 7-bit device address
+ *
+ * @param txbuf buffer of bytes to transmit
+ *
+ * @param txCount number of bytes to transmit
+ *
+ * @param rxbuf buffer for storing received bytes
+ *
+ * @param rxCount number of bytes to receive
+ *
+ * @return 1 if successful, or 0 if the device did not
+ *      acknowledge its address or a transmitted byte
+ */
+int Programmer_i2cTransfer(uint8_t address, const char *txbuf, size_t txCount, char *rxbuf, size_t rxCount);
+
+/**
+ * @brief Set the drive strength of the parallel bus pins.
+ *
+ * Stronger drive and slew rate control help keep edges clean
+ * on long or heavily loaded lines. The setting applies to the
+ * address, data and control pins the next time they are made
+ * outputs, such as by @ref Programmer_initParallel.
+ *
+ * @param drive one of @ref OpenEEPROM_PadDrive
+ *
+ * @return 1 if the drive is supported, else 0
+ */
+int Programmer_setPadDrive(uint8_t drive);
+
+/**
+ * @brief Get the size of the programmer's non-volatile storage.
+ *
+ * Non-volatile storage keeps settings, such as chip profiles,
+ * across power cycles. Programmers without it return 0.
+ *
+ * @return size of the storage in bytes
+ */
+uint32_t Programmer_getStorageSize(void);
+
+/**
+ * @brief Read from non-volatile storage.
+ *
+ * Implementations may require `offset` and `count` to be
+ * multiples of 4; the OpenEEPROM core only issues such accesses.
+ *
+ * @param offset byte offset into the storage
+ *
+ * @param buf buffer for the bytes read
+ *
+ * @param count number of bytes to read
+ *
+ * @return 1 if successful, else 0
+ */
+int Programmer_readStorage(uint32_t offset, char *buf, size_t count);
+
+/**
+ * @brief Write to non-volatile storage.
+ *
+ * The same alignment rules as @ref Programmer_readStorage apply.
+ * This function blocks until the data has been committed.
+ *
+ * @param offset byte offset into the storage
+ *
+ * @param buf bytes to write
+ *
+ * @param count number of bytes to write
+ *
+ * @return 1 if successful, else 0
+ */
+int Programmer_writeStorage(uint32_t offset, const char *buf, size_t count);
+
+/**
+ * @brief Get the size of the programmer's image store.
+ *
+ * The image store is a large non-volatile area, such as
+ * unused internal flash, that holds an image staged for 
+ * standalone programming. Programmers without one return 0.
+ *
+ * @return size of the image store in bytes
+ */
+uint32_t Programmer_getImageStoreSize(void);
+
+/**
+ * @brief Erase the whole image store.
+ *
+ * @return 1 if successful, else 0
+ */
+int Programmer_eraseImageStore(void);
+
+/**
+ * @brief Read from the image store.
+ *
+ * @param offset byte offset into the image store
+ *
+ * @param buf buffer for the bytes read
+ *
+ * @param count number of bytes to read
+ *
+ * @return 1 if successful, else 0
+ */
+int Programmer_readImageStore(uint32_t offset, char *buf, size_t count);
+
+/**
+ * @brief Write to the erased image store.
+ *
+ * Each location may only be written once after 
+ * @ref Programmer_eraseImageStore. The same alignment rules 
+ * as @ref Programmer_readStorage apply, and `buf` must also
+ * be aligned to 4 bytes.
+ *
+ * @param offset byte offset into the image store
+ *
+ * @param buf bytes to write
+ *
+ * @param count number of bytes to write
+ *
+ * @return 1 if successful, else 0
+ */
+int Programmer_writeImageStore(uint32_t offset, const char *buf, size_t count);
+
+/**
+ * @brief Check whether two buses can be used together.
+ *
+ * On programmers that share pins between buses, traffic on
+ * one bus is clocked into the chip on the other. For serial
+ * chips it can form arbitrary instructions, including write
+ * enable followed by an erase or program.
+ *
+ * @param busA an @ref OpenEEPROM_BusMode
+ *
+ * @param busB an @ref OpenEEPROM_BusMode
+ *
+ * @return 1 if the two buses share no pins, else 0
+ */
+int Programmer_busesIndependent(uint8_t busA, uint8_t busB);
+
+/**
+ * @brief Read the standalone programming trigger.
+ *
+ * The trigger is typically a push button that starts
+ * programming the inserted chip without a host.
+ *
+ * @return 1 while the trigger is pressed, else 0
+ */
+int Programmer_getTrigger(void);
+
+/**
+ * @brief Continue a CRC-32 over count bytes.
+ *
+ * The CRC is computed in a running fashion so that a
+ * large range can be fed through in pieces. The first
+ * call should pass 0xFFFFFFFF as `crc`, and the final 
+ * CRC-32 is the inverse of the last returned value.
+ *
+ * @param crc CRC returned by the previous call
+ *
+ * @param buf bytes to add to the CRC
+ *
+ * @param count number of bytes in `buf`
+ *
+ * @return updated CRC
+ */
+uint32_t Programmer_crc32(uint32_t crc, const char *buf, size_t count);
+
+/**
+ * @brief Continue a CRC-16 over count bytes.
+ *
+ * Like @ref Programmer_crc32, but the first call should 
+ * pass 0 as `crc` and the last returned value is final.
+ *
+ * @param crc CRC returned by the previous call
+ *
+ * @param buf bytes to add to the CRC
+ *
+ * @param count number of bytes in `buf`
+ *
+ * @return updated CRC
+ */
+uint16_t Programmer_crc16(uint16_t crc, const char *buf, size_t count);
+
 #endif /* __PROGRAMMER_H__ */
 
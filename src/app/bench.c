@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "platforms/tm4c/driverlib/hw_memmap.h"
+#include "platforms/tm4c/driverlib/hw_types.h"
+#include "platforms/tm4c/driverlib/hw_gpio.h"
+#include "platforms/tm4c/driverlib/gpio.h"
+#include "platforms/tm4c/driverlib/systick.h"
+#include "programmer.h"
+
+#define BENCH_ITERATIONS 1024
+
+/* SysTick cycles taken by the same data bus gather loop placed 
+   in flash and in SRAM. Inspect them with the debugger. */
+volatile uint32_t BenchFlashCycles;
+volatile uint32_t BenchRamCycles;
+
+/* Data lines D0-D7 as wired in platform_tm4c.c. */
+static const uint32_t DataPins[8][2] = {
+    {GPIO_PORTA_BASE, GPIO_PIN_3},
+    {GPIO_PORTA_BASE, GPIO_PIN_4},
+    {GPIO_PORTB_BASE, GPIO_PIN_6},
+    {GPIO_PORTB_BASE, GPIO_PIN_7},
+    {GPIO_PORTC_BASE, GPIO_PIN_5},
+    {GPIO_PORTC_BASE, GPIO_PIN_4},
+    {GPIO_PORTE_BASE, GPIO_PIN_0},
+    {GPIO_PORTB_BASE, GPIO_PIN_2},
+};
+
+static inline __attribute__((always_inline)) uint32_t gatherData(uint32_t iterations) {
+    uint32_t sum = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        uint8_t data = 0;
+        for (int i = 0; i < 8; i++) {
+            data |= (HWREG(DataPins[i][0] + GPIO_O_DATA + (DataPins[i][1] << 2)) ? 1 : 0) << i;
+        }
+        sum += data;
+    }
+    return sum;
+}
+
+static __attribute__((noinline)) uint32_t gatherFromFlash(uint32_t iterations) {
+    return gatherData(iterations);
+}
+
+static __attribute__((section(".ramfunc"), long_call, noinline)) uint32_t gatherFromRam(uint32_t iterations) {
+    return gatherData(iterations);
+}
+
+static uint32_t timeLoop(uint32_t (*loop)(uint32_t)) {
+    uint32_t start = SysTickValueGet();
+    loop(BENCH_ITERATIONS);
+    // SysTick is a 24-bit down counter
+    return (start - SysTickValueGet()) & 0xFFFFFF;
+}
+
+int benchRamfunc(void) {
+    Programmer_init();
+    Programmer_initParallel();
+    Programmer_toggleDataIOMode(0);
+
+    SysTickPeriodSet(0x1000000);
+    SysTickEnable();
+
+    BenchFlashCycles = timeLoop(gatherFromFlash);
+    BenchRamCycles = timeLoop(gatherFromRam);
+
+    return BenchRamCycles < BenchFlashCycles;
+}
@@ -5,12 +5,15 @@
 
 //#define RUN_PARALLEL_TESTS
 
-static char RxBuf[1024];
-static char TxBuf[1024];
+/* Transfer arena placed by the linker script in the SRAM left over after static data. */
+extern char _arena[];
+extern char _earena[];
 
 int testGeneralCommands(void);
 int testParallel(void);
 int testSpi(void);
+int testI2c(void);
+int benchRamfunc(void);
 
 int main(void){
 
@@ -26,7 +29,15 @@ int main(void){
     int result = testSpi();
 #endif
 
-    OpenEEPROM_serverInit(RxBuf, sizeof(RxBuf), TxBuf, sizeof(TxBuf));
+#ifdef RUN_I2C_TESTS
+    int result = testI2c();
+#endif
+
+#ifdef RUN_BENCHMARKS
+    int result = benchRamfunc();
+#endif
+
+    OpenEEPROM_serverInit(_arena, _earena - _arena);
 
     while (1) {
         OpenEEPROM_serverTick();
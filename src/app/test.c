@@ -2,17 +2,29 @@
 #include <stdbool.h>
 #include "string.h"
 #include "open-eeprom.h"
+#include "open-eeprom_conf.h"
 #include "open-eeprom_server.h"
 #include "programmer.h"
 
-static char RxBuf[1024];
-static char TxBuf[1024];
+extern char _arena[];
+extern char _earena[];
+
+/* Tests drive the commands directly, so they split the transfer arena 
+   into fixed request and response halves. */
+#define ArenaSize ((size_t) (_earena - _arena))
+#define RxBuf _arena
+#define TxBuf (&_arena[ArenaSize / 2])
+
+/* Saving a profile writes the programmer's storage, so tests that do
+   copy it to the top of the arena first and put it back afterwards. */
+#define StorageSize Programmer_getStorageSize()
+#define StorageBackup (&_arena[(ArenaSize - StorageSize) & ~(size_t) 3])
 
 int testGeneralCommands(void) {
     size_t response_len = 0;
     int result = 1;
 
-    OpenEEPROM_serverInit(RxBuf, sizeof(RxBuf), TxBuf, sizeof(TxBuf));
+    OpenEEPROM_serverInit(_arena, ArenaSize);
 
     memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_NOP}, 1);
     response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
@@ -31,12 +43,14 @@ int testGeneralCommands(void) {
     memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_GET_MAX_RX_SIZE}, 1);
     response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
     result &= response_len == 5;
-    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x00, 0x04, 0, 0}, response_len) == 0;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+    result &= memcmp(&TxBuf[1], &(uint32_t) {ArenaSize - OPEN_EEPROM_FRAME_RESERVE}, 4) == 0;
 
     memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_GET_MAX_TX_SIZE}, 1);
     response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
     result &= response_len == 5;
-    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x00, 0x04, 0, 0}, response_len) == 0;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+    result &= memcmp(&TxBuf[1], &(uint32_t) {ArenaSize - OPEN_EEPROM_FRAME_RESERVE}, 4) == 0;
 
     memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_TOGGLE_IO, 0}, 2);
     response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
@@ -48,14 +62,40 @@ int testGeneralCommands(void) {
     result &= response_len == 2;
     result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0}, response_len) == 0;
 
+    result &= Programmer_readStorage(0, StorageBackup, StorageSize);
+
+    memcpy(RxBuf, (char[2 + OPEN_EEPROM_PROFILE_NAME_SIZE]) {OPEN_EEPROM_CMD_SAVE_PROFILE, 15, 't', 'e', 's', 't'}, 2 + OPEN_EEPROM_PROFILE_NAME_SIZE);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 15}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SAVE_PROFILE, OPEN_EEPROM_PROFILE_COUNT}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_LIST_PROFILES}, 1);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+    result &= response_len == 2 + (size_t) (uint8_t) TxBuf[1] * (1 + OPEN_EEPROM_PROFILE_NAME_SIZE);
+    result &= memcmp(&TxBuf[response_len - OPEN_EEPROM_PROFILE_NAME_SIZE - 1], (char[]) {15, 't', 'e', 's', 't', 0}, 6) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_APPLY_PROFILE, 15}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_BUS_MODE_NOT_SET}, response_len) == 0;
+
+    result &= Programmer_writeStorage(0, StorageBackup, StorageSize);
+
     return result;
 }
 
 int testParallel(void) {
     size_t response_len = 0;
+    uint32_t holdTime;
     int result = 1;
 
-    OpenEEPROM_serverInit(RxBuf, sizeof(RxBuf), TxBuf, sizeof(TxBuf));
+    OpenEEPROM_serverInit(_arena, ArenaSize);
 
     memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_ADDRESS_BUS_WIDTH, 15}, 2);
     response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
@@ -85,14 +125,366 @@ int testParallel(void) {
     result &= response_len == 5;
     result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xab, 0xcd, 0xef, 0x01}, response_len) == 0;
 
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_PAGE_READ, 3, 0, 0, 0, 100, 0, 0, 0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    // a page-mode read gives the same data as a normal one
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_PAGE_READ, 4, 0, 0, 0, 100, 0, 0, 0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 9;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 4, 0, 0, 0, 100, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xab, 0xcd, 0xef, 0x01}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_PAGE_READ, 1, 0, 0, 0, 0, 0, 0, 0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 9;
+
+    // wider buses go through the address extender, up to its width
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_ADDRESS_BUS_WIDTH, 20}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 20}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_ADDRESS_BUS_WIDTH, 40}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_ADDRESS_BUS_WIDTH, 15}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_DATA_BUS_WIDTH, 12}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_DATA_BUS_WIDTH, 16}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 16}, response_len) == 0;
+
+    // word-wide reads need even addresses and counts
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 1, 0, 0, 0, 0x2, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    // calibration gives up when the reference range cannot be read
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_CALIBRATE_ADDRESS_HOLD_TIME, 1, 0, 0, 0, 0x2, 0, 0, 0, 20, 0, 0, 0}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_DATA_BUS_WIDTH, 8}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 8}, response_len) == 0;
+
+    // calibration never lengthens the hold time beyond the current one plus the margin
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_CALIBRATE_ADDRESS_HOLD_TIME, 0, 0, 0, 0, 0x4, 0, 0, 0, 20, 0, 0, 0}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+    memcpy(&holdTime, &TxBuf[1], sizeof(holdTime));
+    result &= holdTime >= Programmer_MinimumDelay + 20 && holdTime <= 250 + 20;
+
+    // a margin that overflows the hold time is refused
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_CALIBRATE_ADDRESS_HOLD_TIME, 0, 0, 0, 0, 0x4, 0, 0, 0, 
+            0xff, 0xff, 0xff, 0xff}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xab, 0xcd, 0xef, 0x01}, response_len) == 0;
+
+    // the write timing tests below expect the original hold time
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_ADDRESS_HOLD_TIME, 250, 0x00, 0x00, 0x00}, 5);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+
+    // tACC 250, tOE 100 and tWP 250 with every other delay skipped, unknown pad drives are refused
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_PARALLEL_TIMING, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            250, 0, 0, 0, 100, 0, 0, 0, 250, 0, 0, 0, 0, 0, 0, 0, 0xff}, 34);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    RxBuf[33] = OPEN_EEPROM_PAD_DRIVE_8MA;
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xab, 0xcd, 0xef, 0x01}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_WRITE_MODE, OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED}, response_len) == 0;
+
+    // only the second and last bytes differ, the write waits for completion itself
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_WRITE, 0, 0, 0, 0, 0x04, 0, 0 ,0, 0xab, 0x00, 0xef, 0x02}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xab, 0x00, 0xef, 0x02}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_CHECKSUM, OPEN_EEPROM_BUS_MODE_PARALLEL, OPEN_EEPROM_CHECKSUM_SUM, 0, 0, 0, 0, 0x4, 0, 0, 0}, 11);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x9c, 0x01, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_BLANK_CHECK, OPEN_EEPROM_BUS_MODE_PARALLEL, 0xab, 0, 0, 0, 0, 0x4, 0, 0, 0}, 11);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 7;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0, 0x01, 0, 0, 0, 0x00}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_WRITE_RETRIES, 3, 100, 0, 0, 0}, 6);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 6;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 3, 100, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_WRITE_MODE, OPEN_EEPROM_WRITE_MODE_VERIFY}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    // a verified write reports the number of bytes that failed
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_WRITE, 0, 0, 0, 0, 0x04, 0, 0 ,0, 0xab, 0x00, 0xef, 0x02}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0, 0, 0, 0}, response_len) == 0;
+
+    // CRC-32 of {0xab, 0x00} and {0xef, 0x02}
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_BLOCK_HASHES, OPEN_EEPROM_BUS_MODE_PARALLEL, 0, 0, 0, 0, 0x2, 0, 0, 0, 0x2, 0, 0, 0}, 14);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 9;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xdd, 0x77, 0x2a, 0x0c, 0xf0, 0x9c, 0x31, 0x76}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_EPROM_PROGRAMMING, 0xa0, 0x86, 0x01, 0x00, 0, 3, OPEN_EEPROM_EPROM_PULSE_CE}, 8);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_EPROM_PROGRAMMING, 0xa0, 0x86, 0x01, 0x00, 25, 3, OPEN_EEPROM_EPROM_PULSE_PGM}, 8);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 8;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xa0, 0x86, 0x01, 0x00, 25, 3, OPEN_EEPROM_EPROM_PULSE_PGM}, response_len) == 0;
+
+    // bytes already programmed are skipped, and 0x00 cannot become 0xff without an erase
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_EPROM_PROGRAM, 0, 0, 0, 0, 0x04, 0, 0 ,0, 0xab, 0xff, 0xef, 0x02}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 9;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 1, 0, 0, 0, 1, 0, 0, 0}, response_len) == 0;
+
+    // background checksum of the same bytes as the CHECKSUM command above
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_START_JOB, OPEN_EEPROM_JOB_CHECKSUM, OPEN_EEPROM_BUS_MODE_PARALLEL, 
+            OPEN_EEPROM_CHECKSUM_SUM, 0, 0, 0, 0, 0x4, 0, 0, 0, 0, 0, 0, 0}, 16);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+    uint8_t jobId = TxBuf[1];
+
+    while (OpenEEPROM_jobTick())
+        ;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_JOB_STATUS, jobId}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 15;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_JOB_STATE_DONE, 100, 0x4, 0, 0, 0}, 7) == 0;
+    result &= memcmp(&TxBuf[11], (char[]) {0x9c, 0x01, 0, 0}, 4) == 0;
+
+    // a verify job against the wrong CRC-32 fails
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_START_JOB, OPEN_EEPROM_JOB_VERIFY, OPEN_EEPROM_BUS_MODE_PARALLEL, 
+            0, 0, 0, 0, 0, 0x4, 0, 0, 0, 0x12, 0x34, 0x56, 0x78}, 16);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    jobId = TxBuf[1];
+
+    while (OpenEEPROM_jobTick())
+        ;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_JOB_STATUS, jobId}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 15;
+    result &= TxBuf[1] == OPEN_EEPROM_JOB_STATE_FAILED;
+
+    // aborted before its first slice, after which the old ID is unknown
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_START_JOB, OPEN_EEPROM_JOB_CHECKSUM, OPEN_EEPROM_BUS_MODE_PARALLEL, 
+            OPEN_EEPROM_CHECKSUM_CRC32, 0, 0, 0, 0, 0x4, 0, 0, 0, 0, 0, 0, 0}, 16);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_JOB_ABORT, TxBuf[1]}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_JOB_STATE_ABORTED}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_JOB_STATUS, jobId}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    // stage {0xab, 0x00, 0xef, 0x02} as one PackBits literal run, then program and verify it
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_IMAGE_BEGIN, 0x4, 0, 0, 0, 0x17, 0xcf, 0xc6, 0x8c}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_IMAGE_WRITE, 0x2, 0, 0, 0, 0x03, 0xab}, 7);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x2, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_IMAGE_WRITE, 0x3, 0, 0, 0, 0x00, 0xef, 0x02}, 8);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x5, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_IMAGE_END}, 1);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x5, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_START_JOB, OPEN_EEPROM_JOB_PROGRAM_IMAGE, OPEN_EEPROM_BUS_MODE_PARALLEL, 
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 16);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    while (OpenEEPROM_jobTick())
+        ;
+
+    // sectors are only planned for serial flash
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_START_JOB, OPEN_EEPROM_JOB_UPDATE_IMAGE, OPEN_EEPROM_BUS_MODE_PARALLEL, 
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 16);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    // each byte counts once written and once verified
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_JOB_STATUS, 0}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 15;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_JOB_STATE_DONE, 100, 0x8, 0, 0, 0}, 7) == 0;
+    result &= memcmp(&TxBuf[11], (char[]) {0x17, 0xcf, 0xc6, 0x8c}, 4) == 0;
+
+    // copy the first four bytes to the next four on the same chip
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_COPY, OPEN_EEPROM_BUS_MODE_PARALLEL, 0, 0, 0, 0, 
+            OPEN_EEPROM_BUS_MODE_PARALLEL, 0x4, 0, 0, 0, 0x4, 0, 0, 0}, 15);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0x4, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xab, 0x00, 0xef, 0x02}, response_len) == 0;
+
+    // overlapping ranges on one chip are refused
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_COPY, OPEN_EEPROM_BUS_MODE_PARALLEL, 0, 0, 0, 0, 
+            OPEN_EEPROM_BUS_MODE_PARALLEL, 0x2, 0, 0, 0, 0x4, 0, 0, 0}, 15);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    // the serial buses share pins with the parallel bus
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_COPY, OPEN_EEPROM_BUS_MODE_PARALLEL, 0, 0, 0, 0, 
+            OPEN_EEPROM_BUS_MODE_SPI, 0, 0, 0, 0, 0x4, 0, 0, 0}, 15);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_NAK;
+
+    // a two byte pattern over five bytes, verified since the write mode is still VERIFY
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_FILL, OPEN_EEPROM_BUS_MODE_PARALLEL, 0x4, 0, 0, 0, 0x5, 0, 0, 0, 
+            0x2, 0, 0, 0, 0x5a, 0xa5}, 16);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0x4, 0, 0, 0, 0x5, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 6;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x5a, 0xa5, 0x5a, 0xa5, 0x5a}, response_len) == 0;
+
+    // two extents written and three read back in one command each
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_WRITE_EXTENTS, OPEN_EEPROM_BUS_MODE_PARALLEL, 0x2, 0, 0, 0, 
+            0x9, 0, 0, 0, 0x2, 0, 0, 0, 0x2, 0, 0, 0, 0x1, 0, 0, 0, 0x11, 0x22, 0x33}, 25);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_READ_EXTENTS, OPEN_EEPROM_BUS_MODE_PARALLEL, 0x3, 0, 0, 0, 
+            0x9, 0, 0, 0, 0x2, 0, 0, 0, 0x1, 0, 0, 0, 0x2, 0, 0, 0, 0x5, 0, 0, 0, 0x1, 0, 0, 0}, 30);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 6;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x11, 0x22, 0x00, 0x33, 0xa5}, response_len) == 0;
+
+    // two buffered writes continuing each other within an 8 byte page wait for the flush
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_FILL, OPEN_EEPROM_BUS_MODE_PARALLEL, 0x10, 0, 0, 0, 0x4, 0, 0, 0, 
+            0x1, 0, 0, 0, 0xff}, 15);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_PAGE_SIZE, 0x8, 0, 0, 0}, 5);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_WRITE_BUFFERED, OPEN_EEPROM_BUS_MODE_PARALLEL, 0x10, 0, 0, 0, 
+            0x2, 0, 0, 0, 0x44, 0x55}, 12);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_WRITE_BUFFERED, OPEN_EEPROM_BUS_MODE_PARALLEL, 0x12, 0, 0, 0, 
+            0x2, 0, 0, 0, 0x66, 0x77}, 12);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    // run directly rather than through the server, the read does not flush the buffer
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0x10, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0xff, 0xff, 0xff, 0xff}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_FLUSH_WRITES}, 1);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_PARALLEL_READ, 0x10, 0, 0, 0, 0x4, 0, 0 ,0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x44, 0x55, 0x66, 0x77}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_PAGE_SIZE, 0x1, 0, 0, 0}, 5);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+
     return result;
 }
 
+/* Expects a 25-series flash from the known chip table. */
 int testSpi(void) {
     size_t response_len = 0;
     int result = 1;
 
-    OpenEEPROM_serverInit(RxBuf, sizeof(RxBuf), TxBuf, sizeof(TxBuf));
+    OpenEEPROM_serverInit(_arena, ArenaSize);
 
     memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SPI_TRANSMIT, 0x7, 0, 0, 0, 0x02, 0, 0, 0xab, 0xcd, 0xef, 0x12}, 12);
     response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
@@ -104,6 +496,90 @@ int testSpi(void) {
     result &= response_len == 8;
     result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0, 0, 0, 0xab, 0xcd, 0xef, 0x12}, response_len) == 0;
 
+    // in place, the response overwrites the request from its last header byte on
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SPI_TRANSMIT, 7, 0, 0, 0, 0x03, 0, 0, 0, 0, 0, 0}, 12);
+    response_len = OpenEEPROM_runCommand(RxBuf, &RxBuf[4]);
+    result &= response_len == 8;
+    result &= memcmp(&RxBuf[4], (char[]) {OpenEEPROM_ACK, 0, 0, 0, 0xab, 0xcd, 0xef, 0x12}, response_len) == 0;
+
+    // verified serial writes read each page back too
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_WRITE_MODE, OPEN_EEPROM_WRITE_MODE_VERIFY}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SPI_WRITE, 0, 0, 0, 0, 0x4, 0, 0, 0, 0xab, 0xcd, 0xef, 0x12}, 13);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0, 0, 0, 0}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_WRITE_MODE, OPEN_EEPROM_WRITE_MODE_NORMAL}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_IDENTIFY, OPEN_EEPROM_BUS_MODE_SPI}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    // the JEDEC ID is only read correctly in mode 0, so a flash from the known chip table must be named
+    result &= response_len == 6 + OPEN_EEPROM_PROFILE_NAME_SIZE;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_BUS_MODE_SPI}, 2) == 0;
+    result &= TxBuf[6] != 0;
+    char id[3] = {TxBuf[4], TxBuf[3], TxBuf[2]};
+
+    // a saved SPI profile restores mode 0 after another mode was set
+    result &= Programmer_readStorage(0, StorageBackup, StorageSize);
+
+    memcpy(RxBuf, (char[2 + OPEN_EEPROM_PROFILE_NAME_SIZE]) {OPEN_EEPROM_CMD_SAVE_PROFILE, 15, 's', 'p', 'i'}, 2 + OPEN_EEPROM_PROFILE_NAME_SIZE);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_SPI_MODE, OPEN_EEPROM_SPI_MODE_3}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_APPLY_PROFILE, 15}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 2;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_BUS_MODE_SPI}, response_len) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SPI_TRANSMIT, 0x4, 0, 0, 0, 0x9f, 0, 0, 0}, 9);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 5;
+    result &= memcmp(&TxBuf[2], id, sizeof(id)) == 0;
+
+    result &= Programmer_writeStorage(0, StorageBackup, StorageSize);
+
     return result;
 }
 
+/* Expects a single-address 24C32 or larger at 0x50. */
+int testI2c(void) {
+    size_t response_len = 0;
+    int result = 1;
+
+    OpenEEPROM_serverInit(_arena, ArenaSize);
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_SET_I2C_ADDRESS, 0x50, 2}, 3);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 3;
+
+    // contents that do not repeat let the probe tell the address bytes apart
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_FILL, OPEN_EEPROM_BUS_MODE_I2C, 0, 0, 0, 0, 0x10, 0, 0, 0, 0x10, 0, 0, 0, 
+            0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf}, 30);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 1;
+    result &= TxBuf[0] == OpenEEPROM_ACK;
+
+    // one device address is not enough to call it a 24C32, the reads must line up with two address bytes
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_IDENTIFY, OPEN_EEPROM_BUS_MODE_I2C}, 2);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 6 + OPEN_EEPROM_PROFILE_NAME_SIZE;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, OPEN_EEPROM_BUS_MODE_I2C, 0x01, 0x02, 0, 0}, 6) == 0;
+    result &= memcmp(&TxBuf[6], "24C32+", 7) == 0;
+
+    memcpy(RxBuf, (char[]) {OPEN_EEPROM_CMD_READ_EXTENTS, OPEN_EEPROM_BUS_MODE_I2C, 0x1, 0, 0, 0, 
+            0x4, 0, 0, 0, 0x2, 0, 0, 0}, 14);
+    response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    result &= response_len == 3;
+    result &= memcmp(TxBuf, (char[]) {OpenEEPROM_ACK, 0x4, 0x5}, response_len) == 0;
+
+    return result;
+}
@@ -40,15 +40,303 @@ static const uint16_t Version = OPEN_EEPROM_VERSION_NUMBER;
 static const uint8_t SupportedBusTypes = OPEN_EEPROM_SUPPORTED_BUS_TYPES;
 
 static enum OpenEEPROM_BusMode CurrentBusMode = OPEN_EEPROM_BUS_MODE_NOT_SET;
+static uint8_t ReadyBuses = 0;
 static uint8_t CurrentAddressBusWidth = 0;
+static uint8_t NativeAddressWidth = 0;
+static uint32_t UpperAddress = UINT32_MAX;
+static uint32_t StagedUpperAddress;
+static uint8_t CurrentDataBusWidth = 8;
+static uint8_t DataBytes = 1;
 static uint32_t CurrentSpiFrequency = 0;
 static enum OpenEEPROM_SpiMode CurrentSpiMode = OPEN_EEPROM_SPI_MODE_0; 
+static uint8_t CurrentI2cAddress = OPEN_EEPROM_I2C_DEFAULT_ADDRESS;
+static uint8_t CurrentI2cAddressBytes = OPEN_EEPROM_I2C_DEFAULT_ADDRESS_BYTES;
 
-static uint32_t ParallelAddressHoldTime;
-static uint32_t ChipEnablePulseWidthTime;
+static struct OpenEEPROM_ParallelTiming Timing;
+static uint32_t ReadPageSize = 1;
+static uint32_t PageAccessTime;
+static uint8_t CurrentPadDrive = OPEN_EEPROM_PAD_DRIVE_2MA;
+
+/* Delays of a write cycle derived from Timing: CE stays low long enough for
+   address hold and for data set up before the pulse to be valid at its end,
+   and high long enough for data hold and the pulse high time. */
+static uint32_t WritePulseTime;
+static uint32_t WriteRecoveryTime;
+
+static uint8_t CurrentWriteMode = OPEN_EEPROM_WRITE_MODE_NORMAL;
+static uint32_t CurrentPageSize = 1;
+static char PageBuf[OPEN_EEPROM_PAGE_BUFFER_SIZE];
+
+static uint8_t WriteRetries = 0;
+static uint32_t RetryPulseWidthStep = 0;
+static uint32_t WriteFailureCount;
+static uint32_t WriteFailures[OPEN_EEPROM_MAX_REPORTED_FAILURES];
+
+static uint32_t EpromPulseWidth = OPEN_EEPROM_EPROM_PULSE_WIDTH;
+static uint8_t EpromMaxPulses = OPEN_EEPROM_EPROM_MAX_PULSES;
+static uint8_t EpromOverprogram = OPEN_EEPROM_EPROM_OVERPROGRAM;
+static uint8_t EpromPulseLine = OPEN_EEPROM_EPROM_PULSE_CE;
+
+/* Instructions common to 25-series serial flash and EEPROM. */
+#define SPI_INSTRUCTION_WRITE_ENABLE    0x06
+#define SPI_INSTRUCTION_READ_STATUS     0x05
+#define SPI_INSTRUCTION_READ            0x03
+#define SPI_INSTRUCTION_PAGE_PROGRAM    0x02
+#define SPI_STATUS_WIP                  0x01
+#define SPI_HEADER_SIZE                 (1 + OPEN_EEPROM_SPI_ADDRESS_BYTES)
+
+static char ScratchBuf[OPEN_EEPROM_PAGE_BUFFER_SIZE];
+
+#define SPI_INSTRUCTION_CHIP_ERASE      0xC7
+#define SPI_INSTRUCTION_SECTOR_ERASE    0x20
+#define SPI_SECTOR_SIZE                 4096
+#define PARALLEL_COMMAND_ERASE_SETUP    0x80
+#define PARALLEL_COMMAND_CHIP_ERASE     0x10
+
+/* The one background job. Each job started gets a new ID so the host 
+   can tell the job it started from an older one. */
+struct Job {
+    uint8_t id;
+    uint8_t type;
+    uint8_t state;
+    uint8_t bus;
+    uint8_t checksumType;
+    uint32_t address;
+    uint32_t count;
+    uint32_t done;
+    uint32_t programmed;
+    uint32_t started;
+    uint32_t elapsed;
+    uint32_t checksum;
+    uint32_t expected;
+    uint8_t sectorPhase;
+    uint8_t sectorClass;
+    uint32_t sectorOffset;
+    uint32_t sectorStarted;
+};
+
+static struct Job Job;
+
+/* An image update takes the sector at a time through planning, an
+   erase if the plan needs one, and programming. */
+enum SectorPhase {
+    SECTOR_PLAN,
+    SECTOR_ERASE,
+    SECTOR_PROGRAM,
+};
+
+enum SectorClass {
+    SECTOR_UNCHANGED,
+    SECTOR_PROGRAM_ONLY,
+    SECTOR_NEEDS_ERASE,
+};
+
+/* Layout of the image store: a header, written once the upload has 
+   been checked, followed by the PackBits-compressed image. */
+#define IMAGE_MAGIC 0x4f454901
+
+struct ImageHeader {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t packedSize;
+    uint32_t crc;
+};
+
+/* Position within a compressed image and the run being expanded. */
+struct ImageReader {
+    uint32_t offset;
+    uint32_t end;
+    uint32_t run;
+    uint8_t repeat;
+    char value;
+};
+
+/* The image store is written in whole words, so bytes left over from 
+   one IMAGE_WRITE wait at the start of ImageWords for the next. */
+static struct ImageHeader ImageUpload;
+static uint8_t ImageUploading;
+static uint32_t ImageWords[OPEN_EEPROM_PAGE_BUFFER_SIZE / sizeof(uint32_t)];
+static uint8_t ImageTailLen;
+static struct ImageReader ImageReader;
+
+/* Standalone settings are kept in non-volatile storage after the profiles. */
+#define STANDALONE_MAGIC 0x4f455301
+#define STANDALONE_OFFSET (OPEN_EEPROM_PROFILE_COUNT * sizeof(struct ChipProfile))
+
+struct StandaloneConfig {
+    uint32_t magic;
+    uint32_t address;
+    uint8_t enabled;
+    uint8_t slot;
+    uint8_t reserved[2];
+};
+
+static struct StandaloneConfig Standalone;
+static uint8_t StandaloneLoaded;
+static uint8_t TriggerPressed;
+
+/* SPI transfers run in place, so one frame holds both directions. 
+   I2C page writes build their frame here too. */
+static char SpiFrame[SPI_HEADER_SIZE + OPEN_EEPROM_PAGE_BUFFER_SIZE];
+
+/* Chip-to-chip copies alternate between two buffers, so the next chunk 
+   is read while the destination chip is busy writing the last one. */
+static char CopyBuf[2][OPEN_EEPROM_PAGE_BUFFER_SIZE];
+
+/* Buffered writes: a contiguous run within one page waits here until 
+   the page ends, a write elsewhere arrives, or it is flushed. */
+static char CoalesceBuf[OPEN_EEPROM_PAGE_BUFFER_SIZE];
+static uint8_t CoalesceBus;
+static uint32_t CoalesceAddress;
+static size_t CoalesceLen;
+static uint32_t CoalesceStarted;
+static uint8_t CoalesceFailed;
+
+/* A parallel page write that has been started but not waited for. */
+static uint32_t PendingAddress;
+static uint16_t PendingData;
+static uint8_t PendingWrite;
+
+/* Layout of a chip profile in non-volatile storage. The size is a
+   multiple of 4 since storage is accessed in 32-bit words. */
+#define PROFILE_MAGIC 0x4f455004
+
+struct ChipProfile {
+    uint32_t magic;
+    char name[OPEN_EEPROM_PROFILE_NAME_SIZE];
+    uint8_t busMode;
+    uint8_t addressBusWidth;
+    uint8_t spiMode;
+    uint8_t writeMode;
+    uint8_t i2cAddress;
+    uint8_t i2cAddressBytes;
+    uint8_t padDrive;
+    uint8_t dataBusWidth;
+    struct OpenEEPROM_ParallelTiming timing;
+    uint32_t spiFrequency;
+    uint32_t pageSize;
+    uint32_t readPageSize;
+    uint32_t pageAccessTime;
+};
+
+static struct ChipProfile Profile;
+
+/* Chips that IDENTIFY recognises, keyed by bus and ID. SPI IDs are the 
+   3-byte JEDEC ID and I2C IDs the number of device addresses the chip 
+   answers on, plus 0x100 times the number of address bytes it was found
+   to take, or 0 if its contents did not tell. Parallel chips are only
+   reported by ID, see OpenEEPROM_identify. */
+struct KnownChip {
+    uint32_t id;
+    struct ChipProfile profile;
+};
+
+#define SPI_FLASH(id, chipName, page, freq) \
+    {id, {.name = chipName, .busMode = OPEN_EEPROM_BUS_MODE_SPI, .spiMode = OPEN_EEPROM_SPI_MODE_0, \
+        .spiFrequency = freq, .pageSize = page}}
+#define I2C_EEPROM(id, chipName, addressBytes, page) \
+    {id, {.name = chipName, .busMode = OPEN_EEPROM_BUS_MODE_I2C, .i2cAddressBytes = addressBytes, \
+        .pageSize = page}}
+
+static const struct KnownChip KnownChips[] = {
+    SPI_FLASH(0xEF4014, "W25Q80", 256, 50000000),
+    SPI_FLASH(0xEF4015, "W25Q16", 256, 50000000),
+    SPI_FLASH(0xEF4016, "W25Q32", 256, 50000000),
+    SPI_FLASH(0xEF4017, "W25Q64", 256, 50000000),
+    SPI_FLASH(0xEF4018, "W25Q128", 256, 50000000),
+    SPI_FLASH(0xC22016, "MX25L3205", 256, 33000000),
+    SPI_FLASH(0x1F4401, "AT25DF041A", 256, 50000000),
+    SPI_FLASH(0xBF258D, "SST25VF040B", 1, 25000000),
+    I2C_EEPROM(0x108, "24C16", 1, 16),
+    I2C_EEPROM(0x104, "24C08", 1, 16),
+    I2C_EEPROM(0x102, "24C04", 1, 16),
+    I2C_EEPROM(0x101, "24C01/24C02", 1, 8),
+    I2C_EEPROM(0x201, "24C32+", 2, 32),
+};
+
+#define KNOWN_CHIP_COUNT (sizeof(KnownChips) / sizeof(KnownChips[0]))
+
+/* Software product ID commands, written after the 0x5555/0xAA,
+   0x2AAA/0x55 unlock sequence of JEDEC parallel flash. */
+#define PARALLEL_COMMAND_PRODUCT_ID_ENTRY 0x90
+#define PARALLEL_COMMAND_PRODUCT_ID_EXIT  0xF0
+#define PARALLEL_PRODUCT_ID_DELAY         10000
+#define SPI_INSTRUCTION_READ_JEDEC_ID     0x9F
+#define I2C_PROBE_ADDRESS_COUNT           8
+#define I2C_PROBE_WINDOW                  8
 
 static inline int switchToParallelBusMode(void);
 static inline int switchToSpiBusMode(void);
+static inline int switchToI2cBusMode(void);
+
+static int readMemory(uint8_t bus, uint32_t address, char *buf, size_t count);
+static int writeMemory(uint8_t bus, uint32_t address, const char *buf, size_t count);
+static int startPageWrite(uint8_t bus, uint32_t address, const char *buf, size_t count);
+static int waitPageWrite(uint8_t bus);
+static size_t pageChunk(uint8_t bus, uint32_t address, size_t count);
+static int copyMemory(uint8_t srcBus, uint32_t src, uint8_t dstBus, uint32_t dst, size_t count);
+static int checksumMemory(uint8_t bus, uint8_t type, uint32_t address, size_t count, uint32_t *checksum);
+static int checksumStart(uint8_t type, uint32_t *checksum);
+static uint32_t checksumUpdate(uint8_t type, uint32_t checksum, const char *buf, size_t count);
+static uint32_t checksumFinish(uint8_t type, uint32_t checksum);
+
+static int jobStart(struct Job *job);
+static int jobStartErase(uint8_t bus);
+static void jobProgramSlice(void);
+static void jobUpdateSlice(void);
+static int jobEraseDone(void);
+static void jobFinish(uint8_t state);
+static uint8_t jobProgress(void);
+
+OPEN_EEPROM_RAMFUNC static void parallelReadBytes(uint32_t address, char *buf, size_t count);
+OPEN_EEPROM_RAMFUNC static void parallelWriteBytes(uint32_t address, const char *buf, size_t count);
+static int parallelWritePages(uint32_t address, const char *buf, size_t count);
+OPEN_EEPROM_RAMFUNC static int parallelProgramPage(uint32_t address, const char *buf, size_t count, uint32_t pulseWidth, int onlyChanged);
+OPEN_EEPROM_RAMFUNC static size_t parallelStartPage(uint32_t address, const char *buf, size_t count, uint32_t pulseWidth, const char *current);
+OPEN_EEPROM_RAMFUNC static size_t parallelWriteRun(uint32_t address, const char *buf, size_t count, uint32_t pulseWidth, const char *current);
+static int parallelWaitWriteComplete(uint32_t address, uint16_t data);
+static inline int parallelAligned(uint32_t address, size_t count);
+static inline uint16_t parallelLoadWord(const char *buf);
+static int parallelSetDataBusWidth(uint8_t busWidth);
+static int parallelSetAddressBusWidth(uint8_t busWidth);
+static int parallelReadStable(uint32_t address, size_t count);
+static void parallelUpdateWriteTiming(void);
+static void parallelEpromPulse(uint32_t address, uint16_t data, uint32_t pulses);
+static void parallelProgramEprom(uint32_t address, const char *buf, size_t count);
+static int parallelSetPadDrive(uint8_t drive);
+
+static void spiReadBytes(uint32_t address, char *buf, size_t count);
+static int spiWritePages(uint32_t address, const char *buf, size_t count);
+static int spiProgramPage(uint32_t address, const char *buf, size_t count);
+static void spiStartPage(uint32_t address, const char *buf, size_t count);
+static int spiWaitReady(void);
+
+static int i2cReadBytes(uint32_t address, char *buf, size_t count);
+static int i2cWritePages(uint32_t address, const char *buf, size_t count);
+static int i2cStartPage(uint32_t address, const char *buf, size_t count);
+static int i2cWaitReady(void);
+
+static int loadProfile(uint8_t slot, struct ChipProfile *profile);
+static int applyProfile(const struct ChipProfile *profile);
+
+static int loadImageHeader(struct ImageHeader *header);
+static void imageOpen(struct ImageReader *reader, const struct ImageHeader *header);
+static int imageRead(struct ImageReader *reader, char *buf, size_t count);
+
+static struct ImageReader SectorReader;
+
+static void standalonePoll(void);
+static void flushCoalesced(void);
+
+static void recordWriteFailure(uint32_t address);
+static void checkWrittenPage(uint32_t address, const char *buf, size_t count);
+static size_t reportWriteFailures(char *out);
+
+static int spiProbe(uint32_t *id);
+static int i2cProbe(uint32_t *id);
+static uint8_t i2cProbeAddressBytes(uint8_t device);
+static int i2cProbeFits(uint8_t device, uint8_t addressBytes, int *fits);
+static int parallelProbe(uint32_t *id);
 
 /*******************************************
 ********************************************
@@ -124,44 +412,45 @@ int OpenEEPROM_toggleIO(const char *in, char *out) {
     } else {
         Programmer_init(); 
     }
+    ReadyBuses = 0;
 
     memcpy(&out[sizeof(OpenEEPROM_ACK)], &CurrentBusMode, sizeof(CurrentBusMode));
 
     return sizeof(OpenEEPROM_ACK) + sizeof(state);
 }
 
-/*******************************************
-********************************************
-*             Parallel Commands            *
-********************************************
-*******************************************/
-
 /**
- * @brief Set the width of the Address Bus.
+ * @brief Set the mode used by write commands.
  *
- * The programmer needs this information to 
- * set the corrct number of address lines.
+ * The mode is a mask of @ref OpenEEPROM_WriteMode flags.
+ * With OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED set, each page
+ * is read before it is written and write cycles are only 
+ * issued for bytes that differ from the new data. This 
+ * saves both time and endurance when most of a chip is 
+ * reprogrammed with the same contents.
  *
- * @param in 8-bit address bus width
+ * With OPEN_EEPROM_WRITE_MODE_VERIFY set, each page is read
+ * back once it is written. Parallel writes rewrite the bytes
+ * that did not take, see @ref OpenEEPROM_setWriteRetries, 
+ * while SPI and I2C writes only report them.
  *
- * @param out ACK and 8-bit set width or
- *      NAK and max width supported 
- *      by the programmer
+ * @param in 8-bit write mode mask
  *
- * @return 2 
+ * @param out ACK and 8-bit set mode or NAK 
+ *      if the mask contains unknown flags
+ *
+ * @return 2 if successful, else 1
  */
-int OpenEEPROM_setAddressBusWidth(const char *in, char *out) {
-    uint8_t busWidth, maxBusWidth;
+int OpenEEPROM_setWriteMode(const char *in, char *out) {
+    uint8_t mode;
     int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&mode, &in[sizeof(uint8_t)], sizeof(mode));
 
-    maxBusWidth = Programmer_getAddressPinCount();
-    memcpy(&busWidth, &in[sizeof(uint8_t)], sizeof(busWidth));
-     
-    if (busWidth <= maxBusWidth) {
+    if ((mode & ~(OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED | OPEN_EEPROM_WRITE_MODE_VERIFY)) == 0) {
         out[0] = OpenEEPROM_ACK;
-        CurrentAddressBusWidth = busWidth;
-        memcpy(&out[sizeof(OpenEEPROM_ACK)], &busWidth, sizeof(busWidth));
-        response_len += sizeof(CurrentAddressBusWidth);
+        CurrentWriteMode = mode;
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &mode, sizeof(mode));
+        response_len += sizeof(mode);
     } else {
         out[0] = OpenEEPROM_NAK;
     }
@@ -170,268 +459,1705 @@ int OpenEEPROM_setAddressBusWidth(const char *in, char *out) {
 }
 
 /**
- * @brief Set the number of nanoseconds
- * to wait after setting the address lines.
- *
- * Parallel memory chips require a minimum
- * time after setting the address lines 
- * before the data lines can be reliably 
- * read from or written to the desired address.
+ * @brief Set the page size of the attached chip.
  *
- * @param in 32-bit wait time in nanoseconds
+ * Writes never cross a page boundary in a single
+ * program operation. The size must be a power of two 
+ * no larger than OPEN_EEPROM_PAGE_BUFFER_SIZE. 
+ * A size of 1 is safe for any chip.
  *
- * @param out ACK and 32-bit set wait time or
- *      NAK and minimum time supported by 
- *      programmer
+ * @param in 32-bit page size in bytes
  *
- * @return 5
+ * @param out ACK and 32-bit set page size or NAK
  *
+ * @return 5 if successful, else 1
  */
-int OpenEEPROM_setAddressHoldTime(const char *in, char *out) {
-    uint32_t nsecs;
+int OpenEEPROM_setPageSize(const char *in, char *out) {
+    uint32_t size;
     int response_len = sizeof(OpenEEPROM_ACK);
-    memcpy(&nsecs, &in[sizeof(OpenEEPROM_ACK)], sizeof(nsecs)); 
+    memcpy(&size, &in[sizeof(uint8_t)], sizeof(size));
 
-    // TODO: check that nsecs is greater than minimum supported by programmer
-    if (nsecs > 0) {
+    if (size > 0 && size <= OPEN_EEPROM_PAGE_BUFFER_SIZE && (size & (size - 1)) == 0) {
         out[0] = OpenEEPROM_ACK;
-        ParallelAddressHoldTime = nsecs;
-        memcpy(&out[sizeof(OpenEEPROM_ACK)], &nsecs, sizeof(nsecs));
-        response_len += sizeof(nsecs);
+        CurrentPageSize = size;
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &size, sizeof(size));
+        response_len += sizeof(size);
     } else {
         out[0] = OpenEEPROM_NAK;
     }
-    
+
     return response_len;
 }
 
 /**
- * @brief Set the nanosecond pulse width time.
+ * @brief Compute a checksum over a range of memory.
  *
- * Parallel memory chips are enabled when
- * reading or writing and disabled after 
- * a minimum elapsed time to update the 
- * address and data lines; otherwise 
- * reads and writes would be unreliable.
+ * The range is read from the chip on the given bus 
+ * and checksummed on the programmer, so only the 
+ * result is sent back. Supported checksums are
+ * listed in @ref OpenEEPROM_ChecksumType:
  *
- * @param in 32-bit pulse width time in nanoseconds
- * @param out ACK and 32-bit set pulse width time or
- *      NAK and minimum time supported by 
- *      programmer
+ * - CRC-32: the standard (polynomial 0x04C11DB7) CRC-32.
+ * - CRC-16: CRC-16 (polynomial 0x8005), seeded with 0.
+ * - Sum: 32-bit sum of all bytes.
  *
- * @return 5
+ * CRC-16 and sum results are zero-extended to 32 bits.
+ *
+ * @param in 8-bit bus mode, 8-bit checksum type,
+ *      32-bit address and 32-bit count
+ *
+ * @param out ACK and 32-bit checksum or NAK if the
+ *      bus or checksum type is not supported
  *
+ * @return 5 if successful, else 1
  */
-int OpenEEPROM_setAddressPulseWidthTime(const char *in, char *out) {
-    uint32_t nsecs;
+int OpenEEPROM_checksum(const char *in, char *out) {
+    uint8_t bus, type;
+    uint32_t address, count, checksum;
     int response_len = sizeof(OpenEEPROM_ACK);
-    memcpy(&nsecs, &in[sizeof(OpenEEPROM_ACK)], sizeof(nsecs)); 
+    size_t idx = sizeof(uint8_t);
+    memcpy(&bus, &in[idx], sizeof(bus));
+    idx += sizeof(bus);
+    memcpy(&type, &in[idx], sizeof(type));
+    idx += sizeof(type);
+    memcpy(&address, &in[idx], sizeof(address));
+    idx += sizeof(address);
+    memcpy(&count, &in[idx], sizeof(count));
 
-    if (nsecs > 0) {
+    if (checksumMemory(bus, type, address, count, &checksum)) {
         out[0] = OpenEEPROM_ACK;
-        ChipEnablePulseWidthTime = nsecs;
-        memcpy(&out[sizeof(OpenEEPROM_ACK)], &nsecs, sizeof(nsecs));
-        response_len += sizeof(nsecs);
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &checksum, sizeof(checksum));
+        response_len += sizeof(checksum);
     } else {
         out[0] = OpenEEPROM_NAK;
     }
-    
+
     return response_len;
 }
 
 /**
- * @brief Read n bytes from a connected parallel chip.
+ * @brief Check that a range of memory is erased.
  *
- * @param in 32-bit address followed by 32-bit read count
- * @param out ACK followed by n bytes if successful or NAK if 
- *      set address hold time is less than minimum supported
- *      by the programmer
+ * The range is scanned on the programmer and the scan
+ * stops at the first byte that does not hold the 
+ * erased value, so only its address and value are 
+ * sent back. Most chips erase to 0xFF.
  *
- * @return 1 + n (n is read count from input or 0)
+ * @param in 8-bit bus mode, 8-bit erased value,
+ *      32-bit address and 32-bit count
+ *
+ * @param out ACK, 8-bit result (1 if the whole range is 
+ *      blank, else 0), 32-bit address of the first non-blank 
+ *      byte and its 8-bit value; or NAK if the bus is 
+ *      not supported
+ *
+ * @return 7 if successful, else 1
  */
-int OpenEEPROM_parallelRead(const char *in, char *out) {
+int OpenEEPROM_blankCheck(const char *in, char *out) {
+    uint8_t bus, blank, isBlank = 1;
     uint32_t address, count;
-    int response_len = sizeof(OpenEEPROM_ACK);
-    memcpy(&address, &in[sizeof(OpenEEPROM_ACK)], sizeof(address));  
-    memcpy(&count, &in[sizeof(OpenEEPROM_ACK) + sizeof(address)], sizeof(count));  
+    size_t idx = sizeof(uint8_t);
+    memcpy(&bus, &in[idx], sizeof(bus));
+    idx += sizeof(bus);
+    memcpy(&blank, &in[idx], sizeof(blank));
+    idx += sizeof(blank);
+    memcpy(&address, &in[idx], sizeof(address));
+    idx += sizeof(address);
+    memcpy(&count, &in[idx], sizeof(count));
 
-    if (ParallelAddressHoldTime < Programmer_MinimumDelay || !switchToParallelBusMode()) {
-        out[0] = OpenEEPROM_NAK;
-    } else {
-        out[0] = OpenEEPROM_ACK;
-        char *databuf = &out[sizeof(OpenEEPROM_ACK)];
-        Programmer_toggleDataIOMode(0);
-        Programmer_toggleOE(0);
-        Programmer_toggleCE(0);
-        for (size_t i = 0; i < count; i++) {
-            Programmer_setAddress(CurrentAddressBusWidth, address + i);
-            Programmer_delay1ns(ParallelAddressHoldTime);
-            databuf[i] = Programmer_getData();
-        } 
-        Programmer_toggleCE(1);
-        Programmer_toggleOE(1);
-        response_len += count;
+    uint8_t value = blank;
+    while (count > 0 && isBlank) {
+        size_t chunk = count < sizeof(ScratchBuf) ? count : sizeof(ScratchBuf);
+        if (!readMemory(bus, address, ScratchBuf, chunk)) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
+        }
+
+        size_t i = 0;
+        while (i < chunk && (uint8_t) ScratchBuf[i] == blank) {
+            i++;
+        }
+
+        if (i < chunk) {
+            isBlank = 0;
+            value = ScratchBuf[i];
+        }
+        address += i;
+        count -= i;
     }
 
-    return response_len;
+    idx = 0;
+    out[idx++] = OpenEEPROM_ACK;
+    memcpy(&out[idx], &isBlank, sizeof(isBlank));
+    idx += sizeof(isBlank);
+    memcpy(&out[idx], &address, sizeof(address));
+    idx += sizeof(address);
+    memcpy(&out[idx], &value, sizeof(value));
+    idx += sizeof(value);
+
+    return idx;
 }
 
 /**
- * @brief Write n bytes to a connected parallel chip.
+ * @brief Compute the CRC-32 of each block in a range of memory.
  *
- * @param in 32-bit address followed by 32-bit read count
- *      followed by n bytes
+ * The result is a compact table the host can compare against
+ * the same table for a new image, so that only the blocks that
+ * differ need to be rewritten and verified.
  *
- * @param out ACK if successful or NAK if either set address hold time 
- *      or set pulse width time are less than minimum supported
- *      by the programmer
+ * @param in 8-bit bus mode, 32-bit start address,
+ *      32-bit block size and 32-bit block count n
  *
- * @return 1 
+ * @param out ACK followed by n 32-bit CRC-32s, or 
+ *      NAK if the bus is not supported
+ *
+ * @return 1 + 4n if successful, else 1
  */
-int OpenEEPROM_parallelWrite(const char *in, char *out) {
-    uint32_t address, count;
-    int response_len = sizeof(OpenEEPROM_ACK);
-    memcpy(&address, &in[sizeof(OpenEEPROM_ACK)], sizeof(address));  
-    memcpy(&count, &in[sizeof(OpenEEPROM_ACK) + sizeof(address)], sizeof(count));  
+int OpenEEPROM_blockHashes(const char *in, char *out) {
+    uint8_t bus;
+    uint32_t address, blockSize, blockCount, crc;
+    size_t idx = sizeof(uint8_t);
+    memcpy(&bus, &in[idx], sizeof(bus));
+    idx += sizeof(bus);
+    memcpy(&address, &in[idx], sizeof(address));
+    idx += sizeof(address);
+    memcpy(&blockSize, &in[idx], sizeof(blockSize));
+    idx += sizeof(blockSize);
+    memcpy(&blockCount, &in[idx], sizeof(blockCount));
 
-    if (ParallelAddressHoldTime < Programmer_MinimumDelay || 
-            ChipEnablePulseWidthTime < Programmer_MinimumDelay ||
-            !switchToParallelBusMode()) {
-        out[0] = OpenEEPROM_NAK;        
-    } else {
-        out[0] = OpenEEPROM_ACK;
-        const char *databuf = &in[sizeof(OpenEEPROM_ACK) + sizeof(address) + sizeof(count)];
-        Programmer_toggleDataIOMode(1);
-        Programmer_toggleOE(1);
-        Programmer_toggleWE(0);
-        for (size_t i = 0; i < count; i++) {
-            Programmer_setAddress(CurrentAddressBusWidth, address + i);
-            Programmer_setData(databuf[i]);
-            Programmer_delay1ns(ParallelAddressHoldTime);
-            Programmer_toggleCE(0);
-            Programmer_delay1ns(ChipEnablePulseWidthTime);
-            Programmer_toggleCE(1);
+    idx = sizeof(OpenEEPROM_ACK);
+    for (uint32_t i = 0; i < blockCount; i++) {
+        if (!checksumMemory(bus, OPEN_EEPROM_CHECKSUM_CRC32, address, blockSize, &crc)) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
         }
-        Programmer_toggleWE(1);
-        Programmer_toggleDataIOMode(0);
+        memcpy(&out[idx], &crc, sizeof(crc));
+        idx += sizeof(crc);
+        address += blockSize;
     }
 
-    return response_len;
+    out[0] = OpenEEPROM_ACK;
+    return idx;
 }
 
-
-/*******************************************
-********************************************
-*             SPI Commands                 *
-********************************************
-*******************************************/
-
 /**
- * @brief Set the SPI clock frequency.
+ * @brief Save the current settings as a chip profile.
  *
- * @param in 32-bit frequency in Hz
+ * A profile holds the bus mode, address bus width, 
+ * parallel timings, SPI mode and frequency, I2C address,
+ * write mode and page size. Profiles are kept in the 
+ * programmer's non-volatile storage, so a chip that was 
+ * set up once can be selected again by slot after 
+ * a power cycle, see @ref OpenEEPROM_applyProfile.
  *
- * @param out ACK and 32-bit set frequency
- *      or NAK and maximum supported frequency 
+ * @param in 8-bit slot followed by a name of
+ *      OPEN_EEPROM_PROFILE_NAME_SIZE bytes
  *
- * @return 5
- */ 
-int OpenEEPROM_setSpiFrequency(const char *in, char *out) {
-    uint32_t freq;
-    int response_len = sizeof(OpenEEPROM_ACK);
-    memcpy(&freq, &in[sizeof(OpenEEPROM_ACK)], sizeof(freq));
+ * @param out ACK and 8-bit slot, or NAK if the slot
+ *      is out of range or the profile could not be stored
+ *
+ * @return 2 if successful, else 1
+ */
+int OpenEEPROM_saveProfile(const char *in, char *out) {
+    uint8_t slot;
+    uint32_t offset;
+    memcpy(&slot, &in[sizeof(uint8_t)], sizeof(slot));
+    offset = slot * sizeof(Profile);
 
+    if (slot >= OPEN_EEPROM_PROFILE_COUNT || offset + sizeof(Profile) > Programmer_getStorageSize()) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
 
+    Profile.magic = PROFILE_MAGIC;
+    memcpy(Profile.name, &in[sizeof(uint8_t) + sizeof(slot)], sizeof(Profile.name));
+    Profile.busMode = CurrentBusMode;
+    Profile.addressBusWidth = CurrentAddressBusWidth;
+    Profile.spiMode = CurrentSpiMode;
+    Profile.writeMode = CurrentWriteMode;
+    Profile.i2cAddress = CurrentI2cAddress;
+    Profile.i2cAddressBytes = CurrentI2cAddressBytes;
+    Profile.padDrive = CurrentPadDrive;
+    Profile.dataBusWidth = CurrentDataBusWidth;
+    Profile.timing = Timing;
+    Profile.spiFrequency = CurrentSpiFrequency;
+    Profile.pageSize = CurrentPageSize;
+    Profile.readPageSize = ReadPageSize;
+    Profile.pageAccessTime = PageAccessTime;
 
-    // TODO: return maximum supported frequency if input frequency is invalid
-    if (switchToSpiBusMode() && Programmer_setSpiClockFreq(freq)) {
-        out[0] = OpenEEPROM_ACK;
-        CurrentSpiFrequency = freq;
-        memcpy(&out[sizeof(OpenEEPROM_ACK)], &freq, sizeof(freq));
-        response_len += sizeof(freq);
-    } else {
+    if (!Programmer_writeStorage(offset, (const char *) &Profile, sizeof(Profile))) {
         out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
     }
-    
-    return response_len;
+
+    out[0] = OpenEEPROM_ACK;
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &slot, sizeof(slot));
+    return sizeof(OpenEEPROM_ACK) + sizeof(slot);
 }
 
 /**
- * @brief Set the SPI mode.
- *
- * SPI can be configured for 4 different modes, 
- * depending on whether the clock is active high or low
- * and whether data is sampled on the rising edge and 
- * shifted out on the falling edge or vice-versa.
+ * @brief List the saved chip profiles.
  *
- * TODO: confirm these modes are correct.
- * The modes are:
+ * Empty slots are left out of the list.
  *
- * - Mode 0: Active high clock, regular clock polarity.
- * - Mode 1: Active low clock, regular clock polarity.
- * - Mode 2: Active high clock, inverted clock polarity.
- * - Mode 3: Active low clock, inverted clock polarity.
+ * @param out ACK, 8-bit profile count n, then for each
+ *      profile its 8-bit slot and OPEN_EEPROM_PROFILE_NAME_SIZE
+ *      byte name
  *
- * Most devices use mode 0; the programmer may 
- * not support all modes.
+ * @return 2 + n * (1 + OPEN_EEPROM_PROFILE_NAME_SIZE)
+ */
+int OpenEEPROM_listProfiles(const char *in, char *out) {
+    uint8_t count = 0;
+    size_t idx = sizeof(OpenEEPROM_ACK) + sizeof(count);
+
+    for (uint8_t slot = 0; slot < OPEN_EEPROM_PROFILE_COUNT; slot++) {
+        if (loadProfile(slot, &Profile)) {
+            out[idx++] = slot;
+            memcpy(&out[idx], Profile.name, sizeof(Profile.name));
+            idx += sizeof(Profile.name);
+            count++;
+        }
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &count, sizeof(count));
+    return idx;
+}
+
+/**
+ * @brief Restore the settings saved in a chip profile.
  *
- * @param in 8-bit mode
+ * The programmer switches to the profile's bus, so
+ * the chip can be read or written straight away.
  *
- * @param out ACK and 8-bit set mode or NAK
- *      and current mode if input is invalid
+ * @param in 8-bit slot
  *
- * @return 2
+ * @param out ACK and 8-bit bus mode, or NAK if the
+ *      slot is empty or the settings could not be applied
  *
+ * @return 2 if successful, else 1
  */
-int OpenEEPROM_setSpiMode(const char *in, char *out) {
-    uint8_t mode;
-    int response_len = sizeof(OpenEEPROM_ACK);
-    memcpy(&mode, &in[sizeof(OpenEEPROM_ACK)], sizeof(mode));
+int OpenEEPROM_applyProfile(const char *in, char *out) {
+    uint8_t slot;
+    memcpy(&slot, &in[sizeof(uint8_t)], sizeof(slot));
 
-    // TODO: return current mode if input is invalid
-    if (switchToSpiBusMode() && Programmer_setSpiMode(mode)) {
-        out[0] = OpenEEPROM_ACK;
-        CurrentSpiMode = mode;
-        memcpy(&out[sizeof(OpenEEPROM_ACK)], &mode, sizeof(mode));
-        response_len += sizeof(mode);
-    } else {
+    if (!loadProfile(slot, &Profile) || !applyProfile(&Profile)) {
         out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
     }
 
-    return response_len;
+    out[0] = OpenEEPROM_ACK;
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &Profile.busMode, sizeof(Profile.busMode));
+    return sizeof(OpenEEPROM_ACK) + sizeof(Profile.busMode);
 }
 
 /**
- * @brief Return the SPI modes the programmer supports.
+ * @brief Identify the attached chip and apply its profile.
  *
- * The value returned is a mask where each set bit  
- * correponds to a supported SPI mode. The values 
- * correspond to @ref OpenEEPROM_SpiMode. 
+ * The requested buses are probed in turn with conservative 
+ * settings:
  *
- * @param out 8-bit mask of supported SPI modes 
+ * - SPI: the JEDEC ID is read with instruction 0x9F.
+ * - I2C: device addresses from OPEN_EEPROM_I2C_DEFAULT_ADDRESS
+ *   are polled, since 24C04 to 24C16 chips answer on several.
+ *   The start of the chip is then read with one and with two
+ *   address bytes to tell which the chip takes. A blank or 
+ *   repetitive chip may not tell, and is then left with one 
+ *   address byte and a page size of 1.
+ * - Parallel: software product ID mode is entered and left 
+ *   with the JEDEC command sequence. This is last, and only
+ *   done when asked for, since the sequence writes to the 
+ *   chip: on 28C-series EEPROMs without software data 
+ *   protection it overwrites the bytes at 0x2AAA and 0x5555.
  *
- * @return 2
+ * The first bus with a chip on it is kept. If the ID is in 
+ * the programmer's table of known chips, that chip's timings, 
+ * address width and page size are applied the same way as 
+ * with @ref OpenEEPROM_applyProfile. Otherwise the probe 
+ * settings stay in place and the returned name is empty.
+ * The table has no parallel chips: the JEDEC flash that 
+ * answers the probe needs a program command before each 
+ * byte, which the parallel write commands do not send.
  *
+ * @param in 8-bit mask of @ref OpenEEPROM_BusMode to probe
+ *
+ * @param out ACK, 8-bit bus mode, 32-bit ID and the 
+ *      OPEN_EEPROM_PROFILE_NAME_SIZE byte chip name, 
+ *      or NAK if no chip answered
+ *
+ * @return 6 + OPEN_EEPROM_PROFILE_NAME_SIZE if successful, else 1
  */
-int OpenEEPROM_getSupportedSpiModes(const char *in, char *out) {
+int OpenEEPROM_identify(const char *in, char *out) {
+    uint8_t bus;
+    uint8_t buses = in[sizeof(uint8_t)];
+    uint32_t id;
+    size_t idx = sizeof(OpenEEPROM_ACK);
+
+    if ((buses & OPEN_EEPROM_BUS_MODE_SPI) && spiProbe(&id)) {
+        bus = OPEN_EEPROM_BUS_MODE_SPI;
+    } else if ((buses & OPEN_EEPROM_BUS_MODE_I2C) && i2cProbe(&id)) {
+        bus = OPEN_EEPROM_BUS_MODE_I2C;
+    } else if ((buses & OPEN_EEPROM_BUS_MODE_PARALLEL) && parallelProbe(&id)) {
+        bus = OPEN_EEPROM_BUS_MODE_PARALLEL;
+    } else {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    memcpy(&out[idx], &bus, sizeof(bus));
+    idx += sizeof(bus);
+    memcpy(&out[idx], &id, sizeof(id));
+    idx += sizeof(id);
+    for (size_t i = 0; i < OPEN_EEPROM_PROFILE_NAME_SIZE; i++) {
+        out[idx + i] = 0;
+    }
+
+    for (size_t i = 0; i < KNOWN_CHIP_COUNT; i++) {
+        if (KnownChips[i].profile.busMode == bus && KnownChips[i].id == id) {
+            Profile = KnownChips[i].profile;
+            Profile.writeMode = CurrentWriteMode;
+            Profile.i2cAddress = CurrentI2cAddress;
+            if (Profile.spiFrequency > OPEN_EEPROM_MAX_SPI_FREQ) {
+                Profile.spiFrequency = OPEN_EEPROM_MAX_SPI_FREQ;
+            }
+            if (!applyProfile(&Profile)) {
+                out[0] = OpenEEPROM_NAK;
+                return sizeof(OpenEEPROM_NAK);
+            }
+            memcpy(&out[idx], Profile.name, sizeof(Profile.name));
+            break;
+        }
+    }
+
     out[0] = OpenEEPROM_ACK;
-    uint8_t supportedSpiModes = Programmer_getSupportedSpiModes();
-    memcpy(&out[sizeof(OpenEEPROM_ACK)], &supportedSpiModes, sizeof(supportedSpiModes));
-    return sizeof(OpenEEPROM_ACK) + sizeof(supportedSpiModes);
+    return idx + OPEN_EEPROM_PROFILE_NAME_SIZE;
 }
 
 /**
- * @brief Transmit and return n bytes over SPI.
+ * @brief Start a background job.
  *
- * Transmit an array of bytes. Given the nature of SPI
- * the same number of bytes transmitted will also
- * be read back and returned.
+ * The job runs in slices between commands, see 
+ * @ref OpenEEPROM_jobTick, and is followed with
+ * @ref OpenEEPROM_jobStatus. While it runs, only 
+ * commands that do not touch the buses are accepted.
  *
- * @param in 32-bit count of bytes to transmit 
- *      followed by n bytes
+ * - Chip erase: the chip on the bus is erased with the
+ *   25-series instruction 0xC7, or the JEDEC parallel
+ *   command sequence. Address and count are ignored.
+ * - Checksum: as with @ref OpenEEPROM_checksum.
+ * - Verify: the CRC-32 of the range is compared with
+ *   the expected CRC-32.
+ * - Program image: the image staged with @ref OpenEEPROM_imageBegin 
+ *   is written from the address on, in the current write mode, 
+ *   and then verified against its CRC-32. Checksum type, count
+ *   and expected CRC-32 are ignored.
+ * - Update image: as program image, but for serial NOR flash 
+ *   already holding an earlier image. Each 4 KB sector is first
+ *   compared with the image and is erased with the instruction
+ *   0x20 only if a bit must go from 0 to 1. Sectors that already
+ *   match are skipped, and in the others only the page buffers
+ *   that differ are programmed. The address must start a sector,
+ *   and the rest of a last sector that needs erasing is lost.
  *
- * @param out ACK followed by n bytes of data 
- *      or NAK if SPI mode isn't supported
+ * @param in 8-bit @ref OpenEEPROM_JobType, 8-bit bus mode,
+ *      8-bit checksum type, 32-bit address, 32-bit count
+ *      and 32-bit expected CRC-32
+ *
+ * @param out ACK and 8-bit job ID, or NAK if a job is 
+ *      already running or the job cannot be started on the bus
+ *
+ * @return 2 if successful, else 1
+ */
+int OpenEEPROM_startJob(const char *in, char *out) {
+    struct Job job = {0};
+    size_t idx = sizeof(uint8_t);
+    job.type = in[idx++];
+    job.bus = in[idx++];
+    job.checksumType = in[idx++];
+    memcpy(&job.address, &in[idx], sizeof(job.address));
+    idx += sizeof(job.address);
+    memcpy(&job.count, &in[idx], sizeof(job.count));
+    idx += sizeof(job.count);
+    memcpy(&job.expected, &in[idx], sizeof(job.expected));
+
+    if (!jobStart(&job)) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    out[1] = Job.id;
+    return sizeof(OpenEEPROM_ACK) + sizeof(Job.id);
+}
+
+/**
+ * @brief Report the progress of a background job.
+ *
+ * Bytes done counts the bytes processed so far, and for
+ * a chip erase is 0 until the erase has finished. A program
+ * or update job counts each byte twice, once written and once
+ * verified. The result is the checksum of a checksum, verify,
+ * program or update job.
+ *
+ * @param in 8-bit job ID, or 0 for the latest job,
+ *      such as one started by the standalone trigger
+ *
+ * @param out ACK, 8-bit @ref OpenEEPROM_JobState, 8-bit 
+ *      progress in percent, 32-bit bytes done, 32-bit
+ *      elapsed time in milliseconds and 32-bit result,
+ *      or NAK if the ID is not that of the latest job
+ *
+ * @return 15 if successful, else 1
+ */
+int OpenEEPROM_jobStatus(const char *in, char *out) {
+    uint8_t id;
+    memcpy(&id, &in[sizeof(OpenEEPROM_ACK)], sizeof(id));
+
+    if (Job.id == 0 || (id != 0 && id != Job.id)) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    uint32_t elapsed = Job.state == OPEN_EEPROM_JOB_STATE_RUNNING ? 
+        (Programmer_getTicks() - Job.started) / (Programmer_TicksPerSecond / 1000) : Job.elapsed;
+    uint32_t done = Job.programmed + Job.done;
+
+    size_t idx = 0;
+    out[idx++] = OpenEEPROM_ACK;
+    out[idx++] = Job.state;
+    out[idx++] = jobProgress();
+    memcpy(&out[idx], &done, sizeof(done));
+    idx += sizeof(done);
+    memcpy(&out[idx], &elapsed, sizeof(elapsed));
+    idx += sizeof(elapsed);
+    memcpy(&out[idx], &Job.checksum, sizeof(Job.checksum));
+    idx += sizeof(Job.checksum);
+
+    return idx;
+}
+
+/**
+ * @brief Abort a running background job.
+ *
+ * The job stops at the end of its current slice. A chip
+ * erase that has been started cannot be called back; the
+ * chip finishes it regardless and stays busy until then.
+ *
+ * @param in 8-bit job ID
+ *
+ * @param out ACK and 8-bit @ref OpenEEPROM_JobState after
+ *      the abort, or NAK if the ID is not that of the latest job
+ *
+ * @return 2 if successful, else 1
+ */
+int OpenEEPROM_jobAbort(const char *in, char *out) {
+    uint8_t id;
+    memcpy(&id, &in[sizeof(OpenEEPROM_ACK)], sizeof(id));
+
+    if (Job.id == 0 || id != Job.id) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    if (Job.state == OPEN_EEPROM_JOB_STATE_RUNNING) {
+        jobFinish(OPEN_EEPROM_JOB_STATE_ABORTED);
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    out[1] = Job.state;
+    return sizeof(OpenEEPROM_ACK) + sizeof(Job.state);
+}
+
+/**
+ * @brief Start staging an image in the image store.
+ *
+ * The image store is erased, which can take a few seconds, 
+ * and any image staged before is lost. The image is then
+ * sent with @ref OpenEEPROM_imageWrite, compressed with 
+ * PackBits: a header byte n of 0 to 127 is followed by 
+ * n + 1 literal bytes, a header byte n of -1 to -127 is 
+ * followed by one byte repeated 1 - n times, and -128 is 
+ * skipped.
+ *
+ * @param in 32-bit uncompressed image size followed by 
+ *      the 32-bit CRC-32 of the uncompressed image
+ *
+ * @param out ACK, or NAK if the programmer has no image 
+ *      store, a program job is running or the store 
+ *      could not be erased
+ *
+ * @return 1
+ */
+int OpenEEPROM_imageBegin(const char *in, char *out) {
+    ImageUploading = 0;
+    memcpy(&ImageUpload.size, &in[sizeof(uint8_t)], sizeof(ImageUpload.size));
+    memcpy(&ImageUpload.crc, &in[sizeof(uint8_t) + sizeof(ImageUpload.size)], sizeof(ImageUpload.crc));
+    ImageUpload.magic = IMAGE_MAGIC;
+    ImageUpload.packedSize = 0;
+    ImageTailLen = 0;
+
+    if (ImageUpload.size == 0 || Programmer_getImageStoreSize() <= sizeof(ImageUpload) ||
+            (Job.state == OPEN_EEPROM_JOB_STATE_RUNNING && (Job.type == OPEN_EEPROM_JOB_PROGRAM_IMAGE || Job.type == OPEN_EEPROM_JOB_UPDATE_IMAGE)) ||
+            !Programmer_eraseImageStore()) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    ImageUploading = 1;
+    out[0] = OpenEEPROM_ACK;
+    return sizeof(OpenEEPROM_ACK);
+}
+
+/**
+ * @brief Append compressed image data to the image store.
+ *
+ * @param in 32-bit count followed by n bytes
+ *      of PackBits data
+ *
+ * @param out ACK and the 32-bit count of compressed 
+ *      bytes stored so far, or NAK if no image is being 
+ *      staged or the image store is full
+ *
+ * @return 5 if successful, else 1
+ */
+int OpenEEPROM_imageWrite(const char *in, char *out) {
+    char *words = (char *) ImageWords;
+    uint32_t count;
+    memcpy(&count, &in[sizeof(uint8_t)], sizeof(count));
+    const char *data = &in[sizeof(uint8_t) + sizeof(count)];
+
+    if (!ImageUploading || sizeof(ImageUpload) + ImageUpload.packedSize + count > Programmer_getImageStoreSize()) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    while (count > 0) {
+        size_t chunk = sizeof(ImageWords) - ImageTailLen;
+        if (chunk > count) {
+            chunk = count;
+        }
+        uint32_t offset = sizeof(ImageUpload) + ImageUpload.packedSize - ImageTailLen;
+        size_t filled = ImageTailLen + chunk;
+        size_t whole = filled & ~(sizeof(uint32_t) - 1);
+
+        memcpy(&words[ImageTailLen], data, chunk);
+        if (whole > 0) {
+            if (!Programmer_writeImageStore(offset, words, whole)) {
+                ImageUploading = 0;
+                out[0] = OpenEEPROM_NAK;
+                return sizeof(OpenEEPROM_NAK);
+            }
+            memcpy(words, &words[whole], filled - whole);
+        }
+
+        ImageTailLen = filled - whole;
+        ImageUpload.packedSize += chunk;
+        data += chunk;
+        count -= chunk;
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &ImageUpload.packedSize, sizeof(ImageUpload.packedSize));
+    return sizeof(OpenEEPROM_ACK) + sizeof(ImageUpload.packedSize);
+}
+
+/**
+ * @brief Finish staging an image.
+ *
+ * The stored data is expanded and checked against the 
+ * size and CRC-32 given to @ref OpenEEPROM_imageBegin. 
+ * Only then is the image marked valid, so an interrupted
+ * or corrupt upload is never programmed.
+ *
+ * @param out ACK and the 32-bit compressed size, or NAK 
+ *      if no image is being staged or the check failed
+ *
+ * @return 5 if successful, else 1
+ */
+int OpenEEPROM_imageEnd(const char *in, char *out) {
+    struct ImageReader reader;
+    uint32_t crc = 0xFFFFFFFF;
+
+    if (!ImageUploading) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+    ImageUploading = 0;
+
+    /* Pad the last word with PackBits no-ops. */
+    if (ImageTailLen > 0) {
+        char *words = (char *) ImageWords;
+        uint32_t offset = sizeof(ImageUpload) + ImageUpload.packedSize - ImageTailLen;
+        for (size_t i = ImageTailLen; i < sizeof(uint32_t); i++) {
+            words[i] = (char) 0x80;
+        }
+        if (!Programmer_writeImageStore(offset, words, sizeof(uint32_t))) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
+        }
+    }
+
+    imageOpen(&reader, &ImageUpload);
+    for (uint32_t done = 0; done < ImageUpload.size; ) {
+        size_t chunk = ImageUpload.size - done < sizeof(ScratchBuf) ? ImageUpload.size - done : sizeof(ScratchBuf);
+        if (!imageRead(&reader, ScratchBuf, chunk)) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
+        }
+        crc = Programmer_crc32(crc, ScratchBuf, chunk);
+        done += chunk;
+    }
+
+    if (~crc != ImageUpload.crc || reader.run != 0 || reader.offset != reader.end ||
+            !Programmer_writeImageStore(0, (const char *) &ImageUpload, sizeof(ImageUpload))) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &ImageUpload.packedSize, sizeof(ImageUpload.packedSize));
+    return sizeof(OpenEEPROM_ACK) + sizeof(ImageUpload.packedSize);
+}
+
+/**
+ * @brief Set up standalone programming.
+ *
+ * While enabled, pressing the programmer's trigger 
+ * applies the chip profile in the given slot and starts
+ * a program image job on the profile's bus, as with 
+ * @ref OpenEEPROM_startJob. The job's progress can still
+ * be followed with @ref OpenEEPROM_jobStatus. The setting 
+ * is kept in non-volatile storage, so a programming 
+ * fixture runs without a host after a power cycle.
+ *
+ * @param in 8-bit enable, 8-bit profile slot and 
+ *      32-bit address to program the image to
+ *
+ * @param out ACK, or NAK if the profile slot is
+ *      empty or the setting could not be stored
+ *
+ * @return 1
+ */
+int OpenEEPROM_setStandalone(const char *in, char *out) {
+    struct StandaloneConfig config = {0};
+    size_t idx = sizeof(uint8_t);
+    config.magic = STANDALONE_MAGIC;
+    config.enabled = in[idx++] != 0;
+    config.slot = in[idx++];
+    memcpy(&config.address, &in[idx], sizeof(config.address));
+
+    if ((config.enabled && !loadProfile(config.slot, &Profile)) ||
+            STANDALONE_OFFSET + sizeof(config) > Programmer_getStorageSize() ||
+            !Programmer_writeStorage(STANDALONE_OFFSET, (const char *) &config, sizeof(config))) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    Standalone = config;
+    StandaloneLoaded = 1;
+    out[0] = OpenEEPROM_ACK;
+    return sizeof(OpenEEPROM_ACK);
+}
+
+/**
+ * @brief Copy a range from one chip to another.
+ *
+ * The data is read from the source bus and written to the
+ * destination bus a page at a time, as set by
+ * @ref OpenEEPROM_setPageSize, without passing through the 
+ * host. Across buses, reading the next page overlaps the
+ * destination's write cycle. Serial flash destinations must
+ * already be erased. Source and destination may be on the 
+ * same bus, in which case the ranges must not overlap.
+ *
+ * Both chips stay connected during the copy, so buses
+ * that share pins on the programmer cannot be copied 
+ * between, see @ref Programmer_busesIndependent. Each 
+ * bus is set up once rather than on every page.
+ *
+ * @param in 8-bit source bus mode, 32-bit source address,
+ *      8-bit destination bus mode, 32-bit destination address
+ *      and 32-bit count
+ *
+ * @param out ACK, or NAK if either bus is not set up, the 
+ *      buses share pins, the ranges overlap on one bus or
+ *      a write did not complete
+ *
+ * @return 1
+ */
+int OpenEEPROM_copy(const char *in, char *out) {
+    uint8_t srcBus, dstBus;
+    uint32_t src, dst, count;
+    size_t idx = sizeof(uint8_t);
+    srcBus = in[idx++];
+    memcpy(&src, &in[idx], sizeof(src));
+    idx += sizeof(src);
+    dstBus = in[idx++];
+    memcpy(&dst, &in[idx], sizeof(dst));
+    idx += sizeof(dst);
+    memcpy(&count, &in[idx], sizeof(count));
+
+    out[0] = copyMemory(srcBus, src, dstBus, dst, count) ? OpenEEPROM_ACK : OpenEEPROM_NAK;
+    return sizeof(OpenEEPROM_ACK);
+}
+
+/**
+ * @brief Fill a range with a repeating pattern.
+ *
+ * The pattern is repeated from the start address on, so 
+ * a single byte fills the range with a constant. It is 
+ * written a page buffer at a time through the bus's page 
+ * write path in the current write mode, see 
+ * @ref OpenEEPROM_setWriteMode. Serial flash must already
+ * be erased.
+ *
+ * @param in 8-bit bus mode, 32-bit address, 32-bit count and
+ *      32-bit pattern length n, followed by the n pattern bytes
+ *
+ * @param out ACK, or NAK if the pattern is empty or longer than
+ *      OPEN_EEPROM_PAGE_BUFFER_SIZE, the bus is not set up or a
+ *      write did not complete. When verifying, ACK is followed by
+ *      the 32-bit count of failed bytes and the 32-bit addresses 
+ *      of the first OPEN_EEPROM_MAX_REPORTED_FAILURES.
+ *
+ * @return 1, or 5 + 4 * reported failures when verifying
+ */
+int OpenEEPROM_fill(const char *in, char *out) {
+    uint8_t bus;
+    uint32_t address, count, patternLen;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    size_t idx = sizeof(uint8_t);
+    bus = in[idx++];
+    memcpy(&address, &in[idx], sizeof(address));
+    idx += sizeof(address);
+    memcpy(&count, &in[idx], sizeof(count));
+    idx += sizeof(count);
+    memcpy(&patternLen, &in[idx], sizeof(patternLen));
+    idx += sizeof(patternLen);
+    const char *pattern = &in[idx];
+
+    if (patternLen == 0 || patternLen > sizeof(ScratchBuf)) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    WriteFailureCount = 0;
+    out[0] = OpenEEPROM_ACK;
+    for (uint32_t done = 0; done < count; ) {
+        size_t chunk = count - done < sizeof(ScratchBuf) ? count - done : sizeof(ScratchBuf);
+        uint32_t phase = done % patternLen;
+        for (size_t i = 0; i < chunk; i++) {
+            ScratchBuf[i] = pattern[phase];
+            phase = phase + 1 == patternLen ? 0 : phase + 1;
+        }
+        if (!writeMemory(bus, address + done, ScratchBuf, chunk)) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
+        }
+        done += chunk;
+    }
+
+    if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY) {
+        response_len += reportWriteFailures(&out[sizeof(OpenEEPROM_ACK)]);
+    }
+    return response_len;
+}
+
+/**
+ * @brief Read a list of ranges in one command.
+ *
+ * Each extent is a 32-bit address followed by a 32-bit 
+ * length. The extents are read in order and their data 
+ * is returned back to back.
+ *
+ * @param in 8-bit bus mode and 32-bit extent count n,
+ *      followed by the n extents
+ *
+ * @param out ACK followed by the data of every extent, or 
+ *      NAK if any extent could not be read
+ *
+ * @return 1 + the sum of the extent lengths if successful, else 1
+ */
+int OpenEEPROM_readExtents(const char *in, char *out) {
+    uint32_t count, address, length;
+    uint8_t bus = in[sizeof(uint8_t)];
+    size_t idx = sizeof(uint8_t) + sizeof(bus);
+    size_t response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&count, &in[idx], sizeof(count));
+    idx += sizeof(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(&address, &in[idx], sizeof(address));
+        idx += sizeof(address);
+        memcpy(&length, &in[idx], sizeof(length));
+        idx += sizeof(length);
+
+        if (!readMemory(bus, address, &out[response_len], length)) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
+        }
+        response_len += length;
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    return response_len;
+}
+
+/**
+ * @brief Write a list of ranges in one command.
+ *
+ * Each extent is a 32-bit address followed by a 32-bit
+ * length, and the data of all extents follows the list
+ * back to back. The extents are written in order through
+ * the bus's page write path in the current write mode,
+ * as with @ref OpenEEPROM_fill.
+ *
+ * @param in 8-bit bus mode and 32-bit extent count n,
+ *      followed by the n extents and then their data
+ *
+ * @param out ACK, or NAK if an extent could not be written. 
+ *      When verifying, ACK is followed by the 32-bit count of
+ *      failed bytes and the 32-bit addresses of the first 
+ *      OPEN_EEPROM_MAX_REPORTED_FAILURES.
+ *
+ * @return 1, or 5 + 4 * reported failures when verifying
+ */
+int OpenEEPROM_writeExtents(const char *in, char *out) {
+    uint32_t count, address, length;
+    uint8_t bus = in[sizeof(uint8_t)];
+    size_t idx = sizeof(uint8_t) + sizeof(bus);
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&count, &in[idx], sizeof(count));
+    idx += sizeof(count);
+    const char *data = &in[idx + count * (sizeof(address) + sizeof(length))];
+
+    WriteFailureCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(&address, &in[idx], sizeof(address));
+        idx += sizeof(address);
+        memcpy(&length, &in[idx], sizeof(length));
+        idx += sizeof(length);
+
+        if (!writeMemory(bus, address, data, length)) {
+            out[0] = OpenEEPROM_NAK;
+            return sizeof(OpenEEPROM_NAK);
+        }
+        data += length;
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY) {
+        response_len += reportWriteFailures(&out[sizeof(OpenEEPROM_ACK)]);
+    }
+    return response_len;
+}
+
+/**
+ * @brief Write a range through the write buffer.
+ *
+ * Small writes are gathered into whole pages before they
+ * are programmed. Data waits in the buffer until the write
+ * reaches the end of a page, a write that does not continue
+ * it arrives, any other command is run, or it has waited 
+ * OPEN_EEPROM_WRITE_COALESCE_TIMEOUT milliseconds. Each 
+ * page is then written in one operation in the current 
+ * write mode, as with @ref OpenEEPROM_fill.
+ *
+ * Failures are reported by @ref OpenEEPROM_flushWrites.
+ *
+ * @param in 8-bit bus mode, 32-bit address, 32-bit
+ *      count n and n bytes to write
+ *
+ * @param out ACK, or NAK if the bus cannot be written
+ *
+ * @return 1
+ */
+int OpenEEPROM_writeBuffered(const char *in, char *out) {
+    uint8_t bus;
+    uint32_t address, count;
+    size_t idx = sizeof(uint8_t);
+    bus = in[idx++];
+    memcpy(&address, &in[idx], sizeof(address));
+    idx += sizeof(address);
+    memcpy(&count, &in[idx], sizeof(count));
+    idx += sizeof(count);
+    const char *data = &in[idx];
+
+    /* An empty write checks the bus and alignment up front. */
+    if (!writeMemory(bus, address, data, 0) ||
+            (bus == OPEN_EEPROM_BUS_MODE_PARALLEL && !parallelAligned(address, count))) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    while (count > 0) {
+        if (CoalesceLen > 0 && (bus != CoalesceBus || address != CoalesceAddress + CoalesceLen)) {
+            flushCoalesced();
+        }
+        if (CoalesceLen == 0) {
+            CoalesceBus = bus;
+            CoalesceAddress = address;
+            CoalesceStarted = Programmer_getTicks();
+        }
+
+        size_t chunk = pageChunk(bus, address, count);
+        memcpy(&CoalesceBuf[CoalesceLen], data, chunk);
+        CoalesceLen += chunk;
+        address += chunk;
+        data += chunk;
+        count -= chunk;
+
+        if (pageChunk(bus, CoalesceAddress, CoalesceLen + 1) == CoalesceLen) {
+            flushCoalesced();
+        }
+    }
+
+    out[0] = OpenEEPROM_ACK;
+    return sizeof(OpenEEPROM_ACK);
+}
+
+/**
+ * @brief Write out the write buffer.
+ *
+ * @param out ACK if every buffered write since the last 
+ *      flush was programmed, and read back correctly when
+ *      verifying, else NAK
+ *
+ * @return 1
+ */
+int OpenEEPROM_flushWrites(const char *in, char *out) {
+    flushCoalesced();
+    out[0] = CoalesceFailed ? OpenEEPROM_NAK : OpenEEPROM_ACK;
+    CoalesceFailed = 0;
+    return sizeof(OpenEEPROM_ACK);
+}
+
+/**
+ * @brief Program any data waiting in the write buffer.
+ *
+ * The server calls this before running any command 
+ * other than @ref OpenEEPROM_writeBuffered, so that 
+ * no command sees the chip without buffered data.
+ */
+void OpenEEPROM_drainWrites(void) {
+    flushCoalesced();
+}
+
+/**
+ * @brief Check whether a background job is running.
+ *
+ * @return 1 if a job is running, else 0
+ */
+int OpenEEPROM_jobRunning(void) {
+    return Job.state == OPEN_EEPROM_JOB_STATE_RUNNING;
+}
+
+/**
+ * @brief Run the next slice of the background job.
+ *
+ * A slice reads or writes at most one page buffer, or 
+ * polls an erasing chip once, so that commands are answered 
+ * promptly while the job runs. The server calls this
+ * whenever no command is waiting. Without a job, a stale
+ * write buffer is flushed, see @ref OpenEEPROM_writeBuffered,
+ * and the standalone trigger is checked, see 
+ * @ref OpenEEPROM_setStandalone.
+ *
+ * @return 1 if a job is running, else 0
+ */
+int OpenEEPROM_jobTick(void) {
+    if (Job.state != OPEN_EEPROM_JOB_STATE_RUNNING) {
+        if (CoalesceLen > 0 && (Programmer_getTicks() - CoalesceStarted) / (Programmer_TicksPerSecond / 1000) 
+                > OPEN_EEPROM_WRITE_COALESCE_TIMEOUT) {
+            flushCoalesced();
+        }
+        standalonePoll();
+        return 0;
+    }
+
+    if (Job.type == OPEN_EEPROM_JOB_CHIP_ERASE) {
+        if (jobEraseDone()) {
+            Job.done = Job.count;
+            jobFinish(OPEN_EEPROM_JOB_STATE_DONE);
+        } else if ((Programmer_getTicks() - Job.started) / (Programmer_TicksPerSecond / 1000) 
+                > OPEN_EEPROM_CHIP_ERASE_TIMEOUT) {
+            jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        }
+        return 1;
+    }
+
+    if (Job.type == OPEN_EEPROM_JOB_PROGRAM_IMAGE && Job.programmed < Job.count) {
+        jobProgramSlice();
+        return 1;
+    }
+
+    if (Job.type == OPEN_EEPROM_JOB_UPDATE_IMAGE && Job.programmed < Job.count) {
+        jobUpdateSlice();
+        return 1;
+    }
+
+    uint32_t remaining = Job.count - Job.done;
+    size_t chunk = remaining < sizeof(ScratchBuf) ? remaining : sizeof(ScratchBuf);
+    if (!readMemory(Job.bus, Job.address + Job.done, ScratchBuf, chunk)) {
+        jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        return 1;
+    }
+    Job.checksum = checksumUpdate(Job.checksumType, Job.checksum, ScratchBuf, chunk);
+    Job.done += chunk;
+
+    if (Job.done == Job.count) {
+        Job.checksum = checksumFinish(Job.checksumType, Job.checksum);
+        if (Job.type != OPEN_EEPROM_JOB_CHECKSUM && Job.checksum != Job.expected) {
+            jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        } else {
+            jobFinish(OPEN_EEPROM_JOB_STATE_DONE);
+        }
+    }
+    return 1;
+}
+
+/*******************************************
+********************************************
+*             Parallel Commands            *
+********************************************
+*******************************************/
+
+/**
+ * @brief Set the width of the Address Bus.
+ *
+ * The programmer needs this information to 
+ * set the corrct number of address lines.
+ *
+ * Widths beyond the programmer's native address lines
+ * use its address extender, if it has one. The upper 
+ * address bits are then only shifted out when an access
+ * crosses into a new block of native addresses, so 
+ * sequential reads and writes cost nearly the same as 
+ * with native lines.
+ *
+ * @param in 8-bit address bus width
+ *
+ * @param out ACK and 8-bit set width or
+ *      NAK and max width supported 
+ *      by the programmer
+ *
+ * @return 2 
+ */
+int OpenEEPROM_setAddressBusWidth(const char *in, char *out) {
+    uint8_t busWidth;
+    int response_len = sizeof(OpenEEPROM_ACK);
+
+    memcpy(&busWidth, &in[sizeof(uint8_t)], sizeof(busWidth));
+     
+    if (parallelSetAddressBusWidth(busWidth)) {
+        out[0] = OpenEEPROM_ACK;
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &busWidth, sizeof(busWidth));
+        response_len += sizeof(CurrentAddressBusWidth);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+
+    return response_len;
+}
+
+/**
+ * @brief Set the width of the Data Bus.
+ *
+ * Word-wide EPROMs and flash, such as the 27C400 
+ * or a 29F800 in word mode, transfer 16 bits per 
+ * bus cycle. Addresses and counts sent to parallel 
+ * commands stay in bytes, with the low byte of each
+ * word first, but must then be even. The chip's A0 
+ * is driven with bit 1 of the byte address.
+ *
+ * @param in 8-bit data bus width, 8 or 16
+ *
+ * @param out ACK and 8-bit set width or
+ *      NAK if the programmer does not 
+ *      support the width
+ *
+ * @return 2 if successful, else 1
+ */
+int OpenEEPROM_setDataBusWidth(const char *in, char *out) {
+    uint8_t busWidth;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&busWidth, &in[sizeof(uint8_t)], sizeof(busWidth));
+
+    if (busWidth <= Programmer_getDataPinCount() && parallelSetDataBusWidth(busWidth)) {
+        out[0] = OpenEEPROM_ACK;
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &busWidth, sizeof(busWidth));
+        response_len += sizeof(busWidth);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+
+    return response_len;
+}
+
+/**
+ * @brief Set the number of nanoseconds
+ * to wait after setting the address lines.
+ *
+ * Parallel memory chips require a minimum
+ * time after setting the address lines 
+ * before the data lines can be reliably 
+ * read from or written to the desired address.
+ *
+ * This sets both the address access and address setup
+ * times of @ref OpenEEPROM_setParallelTiming to the
+ * same value.
+ *
+ * @param in 32-bit wait time in nanoseconds
+ *
+ * @param out ACK and 32-bit set wait time or
+ *      NAK and minimum time supported by 
+ *      programmer
+ *
+ * @return 5
+ *
+ */
+int OpenEEPROM_setAddressHoldTime(const char *in, char *out) {
+    uint32_t nsecs;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&nsecs, &in[sizeof(OpenEEPROM_ACK)], sizeof(nsecs)); 
+
+    // TODO: check that nsecs is greater than minimum supported by programmer
+    if (nsecs > 0) {
+        out[0] = OpenEEPROM_ACK;
+        Timing.addressAccess = nsecs;
+        Timing.addressSetup = nsecs;
+        parallelUpdateWriteTiming();
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &nsecs, sizeof(nsecs));
+        response_len += sizeof(nsecs);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+    
+    return response_len;
+}
+
+/**
+ * @brief Find the shortest address hold time that reads reliably.
+ *
+ * Parts are usually much faster than their datasheet tACC,
+ * so rather than keep a worst-case hold time, this searches 
+ * for the shortest one at which a sample range reads back 
+ * the same OPEN_EEPROM_CALIBRATION_PASSES times in a row.
+ * The search is a binary search between the programmer's 
+ * minimum delay and the current hold time, which must already
+ * be long enough to read the range correctly; the data read
+ * with it is the reference. The result plus `margin` becomes 
+ * the new address hold time. Only the address access
+ * time is calibrated; write timings are left alone.
+ *
+ * The sample range should hold varied data, since a blank
+ * chip reads the same no matter how short the hold time.
+ *
+ * @param in 32-bit sample address, 32-bit sample count of
+ *      at most OPEN_EEPROM_PAGE_BUFFER_SIZE bytes and 
+ *      32-bit margin in nanoseconds
+ *
+ * @param out ACK and 32-bit set hold time, or NAK if the
+ *      count is out of range, the current hold time is
+ *      less than the minimum supported by the programmer
+ *      or does not read the sample range the same on every
+ *      pass, or the margin would overflow the hold time
+ *
+ * @return 5 if successful, else 1
+ */
+int OpenEEPROM_calibrateAddressHoldTime(const char *in, char *out) {
+    uint32_t address, count, margin, low, high;
+    size_t idx = sizeof(uint8_t);
+    memcpy(&address, &in[idx], sizeof(address));
+    idx += sizeof(address);
+    memcpy(&count, &in[idx], sizeof(count));
+    idx += sizeof(count);
+    memcpy(&margin, &in[idx], sizeof(margin));
+
+    if (count == 0 || count > OPEN_EEPROM_PAGE_BUFFER_SIZE || Timing.addressAccess < Programmer_MinimumDelay 
+            || margin > UINT32_MAX - Timing.addressAccess) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    /* The search relies on the current hold time reading the reference 
+       correctly, so it must at least read it the same every time. */
+    if (!readMemory(OPEN_EEPROM_BUS_MODE_PARALLEL, address, PageBuf, count) || !parallelReadStable(address, count)) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    /* high always reads correctly, low is the fastest not yet ruled out */
+    low = Programmer_MinimumDelay;
+    high = Timing.addressAccess;
+    while (low < high) {
+        Timing.addressAccess = low + (high - low) / 2;
+        if (parallelReadStable(address, count)) {
+            high = Timing.addressAccess;
+        } else {
+            low = Timing.addressAccess + 1;
+        }
+    }
+
+    Timing.addressAccess = high + margin;
+
+    out[0] = OpenEEPROM_ACK;
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &Timing.addressAccess, sizeof(Timing.addressAccess));
+    return sizeof(OpenEEPROM_ACK) + sizeof(Timing.addressAccess);
+}
+
+/**
+ * @brief Set the nanosecond pulse width time.
+ *
+ * Parallel memory chips are enabled when
+ * reading or writing and disabled after 
+ * a minimum elapsed time to update the 
+ * address and data lines; otherwise 
+ * reads and writes would be unreliable.
+ *
+ * This sets the write pulse time of 
+ * @ref OpenEEPROM_setParallelTiming.
+ *
+ * @param in 32-bit pulse width time in nanoseconds
+ * @param out ACK and 32-bit set pulse width time or
+ *      NAK and minimum time supported by 
+ *      programmer
+ *
+ * @return 5
+ *
+ */
+int OpenEEPROM_setAddressPulseWidthTime(const char *in, char *out) {
+    uint32_t nsecs;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&nsecs, &in[sizeof(OpenEEPROM_ACK)], sizeof(nsecs)); 
+
+    if (nsecs > 0) {
+        out[0] = OpenEEPROM_ACK;
+        Timing.writePulse = nsecs;
+        parallelUpdateWriteTiming();
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &nsecs, sizeof(nsecs));
+        response_len += sizeof(nsecs);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+    
+    return response_len;
+}
+
+/**
+ * @brief Set every parallel bus timing at once.
+ *
+ * A single hold time and pulse width have to cover the 
+ * largest of several datasheet constraints. Setting each
+ * timing of @ref OpenEEPROM_ParallelTiming on its own lets
+ * every delay be its true minimum, and a timing of 0 
+ * skips its delay altogether.
+ *
+ * Reads wait tOE once after enabling the outputs and tACC
+ * after each address. Writes wait tAS after setting the 
+ * address and data, hold CE low for the longest of tWP, tAH
+ * and the rest of tDS, then keep it high for the longer of 
+ * tWPH and tDH.
+ *
+ * @param in the eight 32-bit timings of 
+ *      @ref OpenEEPROM_ParallelTiming in nanoseconds,
+ *      then an 8-bit @ref OpenEEPROM_PadDrive
+ *
+ * @param out ACK, or NAK if the pad drive is not
+ *      supported by the programmer
+ *
+ * @return 1
+ */
+int OpenEEPROM_setParallelTiming(const char *in, char *out) {
+    uint8_t drive;
+    memcpy(&drive, &in[sizeof(uint8_t) + sizeof(Timing)], sizeof(drive));
+
+    if (!parallelSetPadDrive(drive)) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    memcpy(&Timing, &in[sizeof(uint8_t)], sizeof(Timing));
+    parallelUpdateWriteTiming();
+
+    out[0] = OpenEEPROM_ACK;
+    return sizeof(OpenEEPROM_ACK);
+}
+
+/**
+ * @brief Set up page-mode reads.
+ *
+ * Page-mode ROMs and flash, such as the 27C322 or 29GL
+ * series, keep a page open once it has been read. Further 
+ * reads that only change the address bits within the page 
+ * need just the page access time tPACC rather than tACC.
+ * With a read page size above 1, parallel reads wait tACC 
+ * only on the first access to each page and tPACC on the 
+ * others.
+ *
+ * @param in 32-bit read page size in bytes, a power of two,
+ *      or 1 to turn page mode off, followed by 32-bit
+ *      page access time in nanoseconds
+ *
+ * @param out ACK and the 32-bit set page size and 
+ *      page access time, or NAK if the size is invalid
+ *
+ * @return 9 if successful, else 1
+ */
+int OpenEEPROM_setPageRead(const char *in, char *out) {
+    uint32_t size, nsecs;
+    size_t idx = sizeof(uint8_t);
+    memcpy(&size, &in[idx], sizeof(size));
+    idx += sizeof(size);
+    memcpy(&nsecs, &in[idx], sizeof(nsecs));
+
+    if (size == 0 || (size & (size - 1)) != 0) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    ReadPageSize = size;
+    PageAccessTime = nsecs;
+
+    idx = 0;
+    out[idx++] = OpenEEPROM_ACK;
+    memcpy(&out[idx], &size, sizeof(size));
+    idx += sizeof(size);
+    memcpy(&out[idx], &nsecs, sizeof(nsecs));
+    idx += sizeof(nsecs);
+
+    return idx;
+}
+
+/**
+ * @brief Set how verified parallel writes retry failing bytes.
+ *
+ * When OPEN_EEPROM_WRITE_MODE_VERIFY is set, bytes that
+ * do not read back correctly are written again up to `retries`
+ * times. Each retry lengthens the pulse width by `step` 
+ * nanoseconds over the previous one, which helps marginal 
+ * cells take the data.
+ *
+ * @param in 8-bit retry count followed by 32-bit 
+ *      pulse width step in nanoseconds
+ *
+ * @param out ACK, 8-bit retry count and 32-bit step
+ *
+ * @return 6
+ */
+int OpenEEPROM_setWriteRetries(const char *in, char *out) {
+    size_t idx = sizeof(uint8_t);
+    memcpy(&WriteRetries, &in[idx], sizeof(WriteRetries));
+    idx += sizeof(WriteRetries);
+    memcpy(&RetryPulseWidthStep, &in[idx], sizeof(RetryPulseWidthStep));
+
+    idx = 0;
+    out[idx++] = OpenEEPROM_ACK;
+    memcpy(&out[idx], &WriteRetries, sizeof(WriteRetries));
+    idx += sizeof(WriteRetries);
+    memcpy(&out[idx], &RetryPulseWidthStep, sizeof(RetryPulseWidthStep));
+    idx += sizeof(RetryPulseWidthStep);
+
+    return idx;
+}
+
+/**
+ * @brief Read n bytes from a connected parallel chip.
+ *
+ * @param in 32-bit address followed by 32-bit read count
+ * @param out ACK followed by n bytes if successful or NAK if 
+ *      set address hold time is less than minimum supported
+ *      by the programmer
+ *
+ * @return 1 + n (n is read count from input or 0)
+ */
+int OpenEEPROM_parallelRead(const char *in, char *out) {
+    uint32_t address, count;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&address, &in[sizeof(OpenEEPROM_ACK)], sizeof(address));  
+    memcpy(&count, &in[sizeof(OpenEEPROM_ACK) + sizeof(address)], sizeof(count));  
+
+    if (Timing.addressAccess < Programmer_MinimumDelay || !parallelAligned(address, count) || !switchToParallelBusMode()) {
+        out[0] = OpenEEPROM_NAK;
+    } else {
+        out[0] = OpenEEPROM_ACK;
+        parallelReadBytes(address, &out[sizeof(OpenEEPROM_ACK)], count);
+        response_len += count;
+    }
+
+    return response_len;
+}
+
+/**
+ * @brief Write n bytes to a connected parallel chip.
+ *
+ * In the normal write mode the bytes are written back to back.
+ * If OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED is set, the data is 
+ * written one page at a time, skipping bytes that already hold
+ * the new value and waiting for the internal write cycle of each
+ * page to complete.
+ *
+ * If OPEN_EEPROM_WRITE_MODE_VERIFY is set, each page is also read 
+ * back and retried as set by @ref OpenEEPROM_setWriteRetries, and
+ * the response lists the addresses that still failed.
+ *
+ * @param in 32-bit address followed by 32-bit read count
+ *      followed by n bytes
+ *
+ * @param out ACK if successful or NAK if either set address hold time 
+ *      or set pulse width time are less than minimum supported
+ *      by the programmer, or if a write cycle timed out. When verifying,
+ *      ACK is followed by the 32-bit count of failed bytes and the 
+ *      32-bit addresses of the first OPEN_EEPROM_MAX_REPORTED_FAILURES.
+ *
+ * @return 1, or 5 + 4 * reported failures when verifying
+ */
+int OpenEEPROM_parallelWrite(const char *in, char *out) {
+    uint32_t address, count;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&address, &in[sizeof(OpenEEPROM_ACK)], sizeof(address));  
+    memcpy(&count, &in[sizeof(OpenEEPROM_ACK) + sizeof(address)], sizeof(count));  
+
+    if (Timing.addressAccess < Programmer_MinimumDelay || 
+            Timing.writePulse < Programmer_MinimumDelay ||
+            !parallelAligned(address, count) ||
+            !switchToParallelBusMode()) {
+        out[0] = OpenEEPROM_NAK;        
+    } else {
+        out[0] = OpenEEPROM_ACK;
+        const char *databuf = &in[sizeof(OpenEEPROM_ACK) + sizeof(address) + sizeof(count)];
+        if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY) {
+            WriteFailureCount = 0;
+            if (parallelWritePages(address, databuf, count)) {
+                response_len += reportWriteFailures(&out[sizeof(OpenEEPROM_ACK)]);
+            } else {
+                out[0] = OpenEEPROM_NAK;
+            }
+        } else if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED) {
+            if (!parallelWritePages(address, databuf, count)) {
+                out[0] = OpenEEPROM_NAK;
+            }
+        } else {
+            parallelWriteBytes(address, databuf, count);
+        }
+    }
+
+    return response_len;
+}
+
+/**
+ * @brief Set up quick-pulse programming of UV EPROMs.
+ *
+ * Each word is given program pulses of the set width, and 
+ * read back after each one, until it verifies or the maximum
+ * number of pulses has been tried. A word that verified after
+ * n pulses then gets one overprogram pulse lasting 
+ * overprogram * n pulse widths; an overprogram factor of 0
+ * skips it. The vendors' quick-pulse algorithms use 100 us
+ * pulses and at most 25 of them.
+ *
+ * @param in 32-bit pulse width in nanoseconds, 8-bit maximum
+ *      pulse count, 8-bit overprogram factor and 8-bit
+ *      @ref OpenEEPROM_EpromPulseLine
+ *
+ * @param out ACK followed by the settings as in `in`, or NAK 
+ *      if the pulse width is less than the minimum supported
+ *      by the programmer, the pulse count is 0 or the pulse 
+ *      line is unknown
+ *
+ * @return 8 if successful, else 1
+ */
+int OpenEEPROM_setEpromProgramming(const char *in, char *out) {
+    uint32_t pulseWidth;
+    uint8_t maxPulses, overprogram, pulseLine;
+    size_t idx = sizeof(uint8_t);
+    memcpy(&pulseWidth, &in[idx], sizeof(pulseWidth));
+    idx += sizeof(pulseWidth);
+    maxPulses = in[idx++];
+    overprogram = in[idx++];
+    pulseLine = in[idx++];
+
+    if (pulseWidth < Programmer_MinimumDelay || maxPulses == 0 || pulseLine > OPEN_EEPROM_EPROM_PULSE_PGM) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
+
+    EpromPulseWidth = pulseWidth;
+    EpromMaxPulses = maxPulses;
+    EpromOverprogram = overprogram;
+    EpromPulseLine = pulseLine;
+
+    idx = 0;
+    out[idx++] = OpenEEPROM_ACK;
+    memcpy(&out[idx], &EpromPulseWidth, sizeof(EpromPulseWidth));
+    idx += sizeof(EpromPulseWidth);
+    out[idx++] = EpromMaxPulses;
+    out[idx++] = EpromOverprogram;
+    out[idx++] = EpromPulseLine;
+
+    return idx;
+}
+
+/**
+ * @brief Program n bytes into a connected UV EPROM.
+ *
+ * Vpp is switched on for the duration of the command and the
+ * words are programmed as set by @ref OpenEEPROM_setEpromProgramming.
+ * Words that already hold their value are skipped, and words that 
+ * would need a 0 bit erased back to 1 fail without being pulsed.
+ * The chip's Vcc must already be at its programming voltage.
+ *
+ * @param in 32-bit address followed by 32-bit count
+ *      followed by n bytes
+ *
+ * @param out ACK followed by the 32-bit count of failed bytes and
+ *      the 32-bit addresses of the first OPEN_EEPROM_MAX_REPORTED_FAILURES,
+ *      or NAK if set address hold time is less than minimum supported
+ *      by the programmer or the programmer cannot switch Vpp
+ *
+ * @return 5 + 4 * reported failures if successful, else 1
+ */
+int OpenEEPROM_epromProgram(const char *in, char *out) {
+    uint32_t address, count;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&address, &in[sizeof(OpenEEPROM_ACK)], sizeof(address));  
+    memcpy(&count, &in[sizeof(OpenEEPROM_ACK) + sizeof(address)], sizeof(count));  
+
+    if (Timing.addressAccess < Programmer_MinimumDelay || 
+            !parallelAligned(address, count) ||
+            !switchToParallelBusMode() ||
+            !Programmer_setVpp(1)) {
+        out[0] = OpenEEPROM_NAK;        
+    } else {
+        out[0] = OpenEEPROM_ACK;
+        Programmer_delay1ns(OPEN_EEPROM_VPP_SETTLE_TIME);
+        WriteFailureCount = 0;
+        parallelProgramEprom(address, &in[sizeof(OpenEEPROM_ACK) + sizeof(address) + sizeof(count)], count);
+        Programmer_setVpp(0);
+        response_len += reportWriteFailures(&out[sizeof(OpenEEPROM_ACK)]);
+    }
+
+    return response_len;
+}
+
+
+/*******************************************
+********************************************
+*             SPI Commands                 *
+********************************************
+*******************************************/
+
+/**
+ * @brief Set the SPI clock frequency.
+ *
+ * @param in 32-bit frequency in Hz
+ *
+ * @param out ACK and 32-bit set frequency
+ *      or NAK and maximum supported frequency 
+ *
+ * @return 5
+ */ 
+int OpenEEPROM_setSpiFrequency(const char *in, char *out) {
+    uint32_t freq;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&freq, &in[sizeof(OpenEEPROM_ACK)], sizeof(freq));
+
+
+
+    // TODO: return maximum supported frequency if input frequency is invalid
+    if (switchToSpiBusMode() && Programmer_setSpiClockFreq(freq)) {
+        out[0] = OpenEEPROM_ACK;
+        CurrentSpiFrequency = freq;
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &freq, sizeof(freq));
+        response_len += sizeof(freq);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+    
+    return response_len;
+}
+
+/**
+ * @brief Set the SPI mode.
+ *
+ * SPI can be configured for 4 different modes, 
+ * depending on whether the clock is active high or low
+ * and whether data is sampled on the rising edge and 
+ * shifted out on the falling edge or vice-versa.
+ *
+ * TODO: confirm these modes are correct.
+ * The modes are:
+ *
+ * - Mode 0: Active high clock, regular clock polarity.
+ * - Mode 1: Active low clock, regular clock polarity.
+ * - Mode 2: Active high clock, inverted clock polarity.
+ * - Mode 3: Active low clock, inverted clock polarity.
+ *
+ * Most devices use mode 0; the programmer may 
+ * not support all modes.
+ *
+ * @param in 8-bit mode
+ *
+ * @param out ACK and 8-bit set mode or NAK
+ *      and current mode if input is invalid
+ *
+ * @return 2
+ *
+ */
+int OpenEEPROM_setSpiMode(const char *in, char *out) {
+    uint8_t mode;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&mode, &in[sizeof(OpenEEPROM_ACK)], sizeof(mode));
+
+    // TODO: return current mode if input is invalid
+    if (switchToSpiBusMode() && Programmer_setSpiMode(mode)) {
+        out[0] = OpenEEPROM_ACK;
+        CurrentSpiMode = mode;
+        memcpy(&out[sizeof(OpenEEPROM_ACK)], &mode, sizeof(mode));
+        response_len += sizeof(mode);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+
+    return response_len;
+}
+
+/**
+ * @brief Return the SPI modes the programmer supports.
+ *
+ * The value returned is a mask where each set bit  
+ * correponds to a supported SPI mode. The values 
+ * correspond to @ref OpenEEPROM_SpiMode. 
+ *
+ * @param out 8-bit mask of supported SPI modes 
+ *
+ * @return 2
+ *
+ */
+int OpenEEPROM_getSupportedSpiModes(const char *in, char *out) {
+    out[0] = OpenEEPROM_ACK;
+    uint8_t supportedSpiModes = Programmer_getSupportedSpiModes();
+    memcpy(&out[sizeof(OpenEEPROM_ACK)], &supportedSpiModes, sizeof(supportedSpiModes));
+    return sizeof(OpenEEPROM_ACK) + sizeof(supportedSpiModes);
+}
+
+/**
+ * @brief Transmit and return n bytes over SPI.
+ *
+ * Transmit an array of bytes. Given the nature of SPI
+ * the same number of bytes transmitted will also
+ * be read back and returned.
+ *
+ * The transfer may run in place: the server places `out`
+ * so that the received bytes overwrite the transmitted 
+ * ones in the input buffer, which lets a single buffer 
+ * hold the largest transfer.
+ *
+ * @param in 32-bit count of bytes to transmit 
+ *      followed by n bytes
+ *
+ * @param out ACK followed by n bytes of data 
+ *      or NAK if SPI mode isn't supported
  *
  * @return 1 + n (transmit count from input or 0)
  */
@@ -440,37 +2166,1415 @@ int OpenEEPROM_spiTransmit(const char *in, char *out) {
     int response_len = sizeof(OpenEEPROM_ACK);
     memcpy(&count, &in[sizeof(OpenEEPROM_ACK)], sizeof(count));  
 
-    if (!switchToSpiBusMode()) {
-        out[0] = OpenEEPROM_NAK; 
+    if (!switchToSpiBusMode()) {
+        out[0] = OpenEEPROM_NAK; 
+    } else {
+        if (Programmer_spiTransmit(&in[sizeof(uint8_t) + sizeof(count)], &out[sizeof(OpenEEPROM_ACK)], count)) {
+            out[0] = OpenEEPROM_ACK;
+            response_len += count;
+        } else {
+            out[0] = OpenEEPROM_NAK; 
+        }
+    }
+
+    return response_len;
+}
+
+/**
+ * @brief Write n bytes to a connected SPI memory.
+ *
+ * The data is programmed with the 25-series page program 
+ * instruction, split on the set page size, and the status
+ * register is polled until each page has been written.
+ * If OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED is set, pages 
+ * that already hold the new data are skipped and only the 
+ * span of changed bytes is programmed in the rest.
+ * If OPEN_EEPROM_WRITE_MODE_VERIFY is set, each page is also
+ * read back and the response lists the addresses that failed.
+ *
+ * @param in 32-bit address followed by 32-bit write count
+ *      followed by n bytes
+ *
+ * @param out ACK if successful or NAK if a page program 
+ *      timed out. When verifying, ACK is followed by the 
+ *      32-bit count of failed bytes and the 32-bit addresses
+ *      of the first OPEN_EEPROM_MAX_REPORTED_FAILURES.
+ *
+ * @return 1, or 5 + 4 * reported failures when verifying
+ */
+int OpenEEPROM_spiWrite(const char *in, char *out) {
+    uint32_t address, count;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&address, &in[sizeof(OpenEEPROM_ACK)], sizeof(address));  
+    memcpy(&count, &in[sizeof(OpenEEPROM_ACK) + sizeof(address)], sizeof(count));  
+
+    const char *databuf = &in[sizeof(OpenEEPROM_ACK) + sizeof(address) + sizeof(count)];
+    WriteFailureCount = 0;
+    if (switchToSpiBusMode() && spiWritePages(address, databuf, count)) {
+        out[0] = OpenEEPROM_ACK;
+        if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY) {
+            response_len += reportWriteFailures(&out[sizeof(OpenEEPROM_ACK)]);
+        }
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+
+    return response_len;
+}
+
+/*******************************************
+********************************************
+*             I2C Commands                 *
+********************************************
+*******************************************/
+
+/**
+ * @brief Set the address of the I2C memory.
+ *
+ * 24-series memories respond to a 7-bit device
+ * address (usually 0x50) and are addressed internally 
+ * with one or two bytes. Parts with one address byte 
+ * and more than 256 bytes, like the 24C16, take the 
+ * upper address bits in the low bits of the device 
+ * address; this is handled automatically.
+ *
+ * @param in 7-bit device address followed by 
+ *      8-bit count of address bytes (1 or 2)
+ *
+ * @param out ACK and the set device address and address 
+ *      byte count, or NAK if either is invalid
+ *
+ * @return 3 if successful, else 1
+ */
+int OpenEEPROM_setI2cAddress(const char *in, char *out) {
+    uint8_t address, addressBytes;
+    int response_len = sizeof(OpenEEPROM_ACK);
+    memcpy(&address, &in[sizeof(uint8_t)], sizeof(address));
+    memcpy(&addressBytes, &in[sizeof(uint8_t) + sizeof(address)], sizeof(addressBytes));
+
+    if (address < 0x80 && (addressBytes == 1 || addressBytes == 2)) {
+        out[0] = OpenEEPROM_ACK;
+        CurrentI2cAddress = address;
+        CurrentI2cAddressBytes = addressBytes;
+        memcpy(&out[response_len], &address, sizeof(address));
+        response_len += sizeof(address);
+        memcpy(&out[response_len], &addressBytes, sizeof(addressBytes));
+        response_len += sizeof(addressBytes);
+    } else {
+        out[0] = OpenEEPROM_NAK;
+    }
+
+    return response_len;
+}
+
+/* Note that bus has just been set up. Any other bus sharing pins 
+   with it must be set up again before its next use. */
+static void markBusReady(uint8_t bus) {
+    uint8_t ready = bus;
+    for (uint8_t other = OPEN_EEPROM_BUS_MODE_PARALLEL; other <= OPEN_EEPROM_BUS_MODE_I2C; other <<= 1) {
+        if ((ReadyBuses & other) && Programmer_busesIndependent(bus, other)) {
+            ready |= other;
+        }
+    }
+    ReadyBuses = ready;
+}
+
+static inline int switchToParallelBusMode(void) {
+    if (CurrentBusMode == OPEN_EEPROM_BUS_MODE_PARALLEL) {
+        return 1;
+    } else if (OPEN_EEPROM_BUS_MODE_PARALLEL & SupportedBusTypes) {
+        if (!(ReadyBuses & OPEN_EEPROM_BUS_MODE_PARALLEL)) {
+            Programmer_initParallel();
+            markBusReady(OPEN_EEPROM_BUS_MODE_PARALLEL);
+            UpperAddress = UINT32_MAX;
+        }
+        CurrentBusMode = OPEN_EEPROM_BUS_MODE_PARALLEL;
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static inline int switchToSpiBusMode(void) {
+    if (CurrentBusMode == OPEN_EEPROM_BUS_MODE_SPI) {
+        return 1;
+    } else if (OPEN_EEPROM_BUS_MODE_SPI & SupportedBusTypes) {
+        if (!(ReadyBuses & OPEN_EEPROM_BUS_MODE_SPI)) {
+            Programmer_initSpi();
+            markBusReady(OPEN_EEPROM_BUS_MODE_SPI);
+        }
+        CurrentBusMode = OPEN_EEPROM_BUS_MODE_SPI;
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+/* Read from the chip on any supported bus, switching to it if necessary. */
+static int readMemory(uint8_t bus, uint32_t address, char *buf, size_t count) {
+    switch (bus) {
+        case OPEN_EEPROM_BUS_MODE_PARALLEL:
+            if (Timing.addressAccess < Programmer_MinimumDelay || !parallelAligned(address, count) 
+                    || !switchToParallelBusMode()) {
+                return 0;
+            }
+            parallelReadBytes(address, buf, count);
+            return 1;
+
+        case OPEN_EEPROM_BUS_MODE_SPI:
+            if (!switchToSpiBusMode()) {
+                return 0;
+            }
+            spiReadBytes(address, buf, count);
+            return 1;
+
+        case OPEN_EEPROM_BUS_MODE_I2C:
+            return switchToI2cBusMode() && i2cReadBytes(address, buf, count);
+
+        default:
+            return 0;
+    }
+}
+
+/* Write through the bus's page write path, waiting for each page. */
+static int writeMemory(uint8_t bus, uint32_t address, const char *buf, size_t count) {
+    switch (bus) {
+        case OPEN_EEPROM_BUS_MODE_PARALLEL:
+            if (Timing.addressAccess < Programmer_MinimumDelay || 
+                    Timing.writePulse < Programmer_MinimumDelay ||
+                    !parallelAligned(address, count) ||
+                    !switchToParallelBusMode()) {
+                return 0;
+            }
+            return parallelWritePages(address, buf, count);
+
+        case OPEN_EEPROM_BUS_MODE_SPI:
+            return switchToSpiBusMode() && spiWritePages(address, buf, count);
+
+        case OPEN_EEPROM_BUS_MODE_I2C:
+            return switchToI2cBusMode() && i2cWritePages(address, buf, count);
+
+        default:
+            return 0;
+    }
+}
+
+/* Start programming a range within one page without waiting for the 
+   chip to finish, so the caller can do other work meanwhile. */
+static int startPageWrite(uint8_t bus, uint32_t address, const char *buf, size_t count) {
+    switch (bus) {
+        case OPEN_EEPROM_BUS_MODE_PARALLEL:
+            if (Timing.addressAccess < Programmer_MinimumDelay || 
+                    Timing.writePulse < Programmer_MinimumDelay ||
+                    !parallelAligned(address, count) ||
+                    !switchToParallelBusMode()) {
+                return 0;
+            }
+            size_t last = parallelStartPage(address, buf, count, WritePulseTime, NULL);
+            PendingWrite = last < count;
+            if (PendingWrite) {
+                PendingAddress = address + last;
+                PendingData = parallelLoadWord(&buf[last]);
+            }
+            return 1;
+
+        case OPEN_EEPROM_BUS_MODE_SPI:
+            if (!switchToSpiBusMode()) {
+                return 0;
+            }
+            spiStartPage(address, buf, count);
+            return 1;
+
+        case OPEN_EEPROM_BUS_MODE_I2C:
+            return switchToI2cBusMode() && i2cStartPage(address, buf, count);
+
+        default:
+            return 0;
+    }
+}
+
+static int waitPageWrite(uint8_t bus) {
+    switch (bus) {
+        case OPEN_EEPROM_BUS_MODE_PARALLEL:
+            return !PendingWrite || (switchToParallelBusMode() && parallelWaitWriteComplete(PendingAddress, PendingData));
+        case OPEN_EEPROM_BUS_MODE_SPI:
+            return switchToSpiBusMode() && spiWaitReady();
+        case OPEN_EEPROM_BUS_MODE_I2C:
+            return switchToI2cBusMode() && i2cWaitReady();
+        default:
+            return 0;
+    }
+}
+
+/* Bytes from address to the end of its page, at most count. Pages are 
+   capped at the copy buffer size and hold at least one bus word. */
+static size_t pageChunk(uint8_t bus, uint32_t address, size_t count) {
+    uint32_t pageSize = CurrentPageSize < sizeof(CopyBuf[0]) ? CurrentPageSize : sizeof(CopyBuf[0]);
+    if (bus == OPEN_EEPROM_BUS_MODE_PARALLEL && pageSize < DataBytes) {
+        pageSize = DataBytes;
+    }
+    size_t chunk = pageSize - (address & (pageSize - 1));
+    return chunk < count ? chunk : count;
+}
+
+/* Program the buffered run, keeping any failure for the next flush. */
+static void flushCoalesced(void) {
+    if (CoalesceLen == 0) {
+        return;
+    }
+    WriteFailureCount = 0;
+    if (!writeMemory(CoalesceBus, CoalesceAddress, CoalesceBuf, CoalesceLen) || WriteFailureCount > 0) {
+        CoalesceFailed = 1;
+    }
+    CoalesceLen = 0;
+}
+
+/* Copy a page at a time. Across buses, the next chunk is read while the
+   destination is still busy; on one bus the chip must be ready first. 
+   Overlapping ranges on one bus are refused. */
+static int copyMemory(uint8_t srcBus, uint32_t src, uint8_t dstBus, uint32_t dst, size_t count) {
+    int pipelined = srcBus != dstBus;
+    int cur = 0;
+    size_t chunk = pageChunk(dstBus, dst, count);
+
+    if (pipelined && !Programmer_busesIndependent(srcBus, dstBus)) {
+        return 0;
+    }
+    if (!pipelined && count > 0 && (dst - src < count || src - dst < count)) {
+        return 0;
+    }
+    if (!readMemory(srcBus, src, CopyBuf[cur], chunk)) {
+        return 0;
+    }
+    while (count > 0) {
+        if (!startPageWrite(dstBus, dst, CopyBuf[cur], chunk)) {
+            return 0;
+        }
+        src += chunk;
+        dst += chunk;
+        count -= chunk;
+
+        size_t next = pageChunk(dstBus, dst, count);
+        if (pipelined && next > 0 && !readMemory(srcBus, src, CopyBuf[!cur], next)) {
+            waitPageWrite(dstBus);
+            return 0;
+        }
+        if (!waitPageWrite(dstBus)) {
+            return 0;
+        }
+        if (!pipelined && next > 0 && !readMemory(srcBus, src, CopyBuf[!cur], next)) {
+            return 0;
+        }
+        cur = !cur;
+        chunk = next;
+    }
+    return 1;
+}
+
+static int checksumMemory(uint8_t bus, uint8_t type, uint32_t address, size_t count, uint32_t *checksum) {
+    uint32_t result;
+
+    if (!checksumStart(type, &result)) {
+        return 0;
+    }
+
+    while (count > 0) {
+        size_t chunk = count < sizeof(ScratchBuf) ? count : sizeof(ScratchBuf);
+        if (!readMemory(bus, address, ScratchBuf, chunk)) {
+            return 0;
+        }
+        result = checksumUpdate(type, result, ScratchBuf, chunk);
+        address += chunk;
+        count -= chunk;
+    }
+
+    *checksum = checksumFinish(type, result);
+    return 1;
+}
+
+/* Running checksums, so that a range can be checksummed in pieces. */
+static int checksumStart(uint8_t type, uint32_t *checksum) {
+    switch (type) {
+        case OPEN_EEPROM_CHECKSUM_CRC32:
+            *checksum = 0xFFFFFFFF;
+            return 1;
+        case OPEN_EEPROM_CHECKSUM_CRC16:
+        case OPEN_EEPROM_CHECKSUM_SUM:
+            *checksum = 0;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t checksumUpdate(uint8_t type, uint32_t checksum, const char *buf, size_t count) {
+    if (type == OPEN_EEPROM_CHECKSUM_CRC32) {
+        return Programmer_crc32(checksum, buf, count);
+    } else if (type == OPEN_EEPROM_CHECKSUM_CRC16) {
+        return Programmer_crc16(checksum, buf, count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        checksum += (uint8_t) buf[i];
+    }
+    return checksum;
+}
+
+static uint32_t checksumFinish(uint8_t type, uint32_t checksum) {
+    return type == OPEN_EEPROM_CHECKSUM_CRC32 ? ~checksum : checksum;
+}
+
+static inline int switchToI2cBusMode(void) {
+    if (CurrentBusMode == OPEN_EEPROM_BUS_MODE_I2C) {
+        return 1;
+    } else if (OPEN_EEPROM_BUS_MODE_I2C & SupportedBusTypes) {
+        if (!(ReadyBuses & OPEN_EEPROM_BUS_MODE_I2C)) {
+            Programmer_initI2c();
+            markBusReady(OPEN_EEPROM_BUS_MODE_I2C);
+        }
+        CurrentBusMode = OPEN_EEPROM_BUS_MODE_I2C;
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static inline void parallelDelay(uint32_t nsecs) {
+    if (nsecs != 0) {
+        Programmer_delay1ns(nsecs);
+    }
+}
+
+/* On a 16-bit bus, bus cycles move a little-endian word and the 
+   chip's address lines count words rather than bytes. */
+static inline int parallelAligned(uint32_t address, size_t count) {
+    return ((address | count) & (DataBytes - 1)) == 0;
+}
+
+static inline uint32_t parallelBusAddress(uint32_t address) {
+    return DataBytes == 1 ? address : address >> 1;
+}
+
+/* Only shift out the upper bits when they differ from those latched. */
+static inline void parallelSetAddress(uint32_t busAddress) {
+    if (CurrentAddressBusWidth > NativeAddressWidth) {
+        uint32_t upper = busAddress >> NativeAddressWidth;
+        if (upper != UpperAddress) {
+            Programmer_setUpperAddress(upper);
+            UpperAddress = upper;
+        }
+    }
+    Programmer_setAddress(NativeAddressWidth, busAddress);
+}
+
+static inline uint16_t parallelLoadWord(const char *buf) {
+    return DataBytes == 1 ? (uint8_t) buf[0] : (uint8_t) buf[0] | (uint8_t) buf[1] << 8;
+}
+
+static inline void parallelStoreWord(char *buf, uint16_t data) {
+    buf[0] = data & 0xFF;
+    if (DataBytes == 2) {
+        buf[1] = data >> 8;
+    }
+}
+
+/* In page mode only the first access to each read page waits the full
+   tACC; with page mode off every address opens a new "page". */
+OPEN_EEPROM_RAMFUNC static void parallelReadBytes(uint32_t address, char *buf, size_t count) {
+    uint32_t pageMask = ReadPageSize > DataBytes ? ~(parallelBusAddress(ReadPageSize) - 1) : UINT32_MAX;
+    uint32_t openPage = UINT32_MAX;
+
+    Programmer_toggleDataIOMode(0);
+    Programmer_toggleOE(0);
+    Programmer_toggleCE(0);
+    parallelDelay(Timing.outputEnable);
+    for (size_t i = 0; i < count; i += DataBytes) {
+        uint32_t busAddress = parallelBusAddress(address + i);
+        parallelSetAddress(busAddress);
+        if ((busAddress & pageMask) == openPage) {
+            parallelDelay(PageAccessTime);
+        } else {
+            parallelDelay(Timing.addressAccess);
+            openPage = busAddress & pageMask;
+        }
+        parallelStoreWord(&buf[i], Programmer_getData());
+    } 
+    Programmer_toggleCE(1);
+    Programmer_toggleOE(1);
+}
+
+static inline void parallelWriteCycle(uint32_t address, uint16_t data, uint32_t pulseWidth) {
+    parallelSetAddress(parallelBusAddress(address));
+    Programmer_setData(data);
+    parallelDelay(Timing.addressSetup);
+    Programmer_toggleCE(0);
+    parallelDelay(pulseWidth);
+    Programmer_toggleCE(1);
+    parallelDelay(WriteRecoveryTime);
+}
+
+/* The upper address bits change outputs at once, so unlike the native 
+   lines they are only latched when the staged write is committed. */
+static inline void parallelStageWrite(uint32_t address, uint16_t data) {
+    uint32_t busAddress = parallelBusAddress(address);
+    StagedUpperAddress = busAddress >> NativeAddressWidth;
+    Programmer_stageWrite(NativeAddressWidth, busAddress, data);
+}
+
+static inline void parallelCommitWrite(void) {
+    if (CurrentAddressBusWidth > NativeAddressWidth && StagedUpperAddress != UpperAddress) {
+        Programmer_setUpperAddress(StagedUpperAddress);
+        UpperAddress = StagedUpperAddress;
+    }
+    Programmer_commitWrite();
+}
+
+/* Index of the next word to write, skipping those `current` shows
+   already hold the new value. */
+static inline size_t parallelNextWrite(const char *buf, const char *current, size_t i, size_t count) {
+    while (i < count && current != NULL && parallelLoadWord(&current[i]) == parallelLoadWord(&buf[i])) {
+        i += DataBytes;
+    }
+    return i;
+}
+
+/* Software pipeline: while the write pulse of one word runs, the port 
+   images of the next are computed, so each cycle costs little more than
+   its timings. Every wait is against a deadline started beforehand. 
+   Returns the index of the last word written, or count if none were. */
+OPEN_EEPROM_RAMFUNC static size_t parallelWriteRun(uint32_t address, const char *buf, size_t count, uint32_t pulseWidth, const char *current) {
+    size_t last = count;
+    size_t i = parallelNextWrite(buf, current, 0, count);
+
+    if (i < count) {
+        parallelStageWrite(address + i, parallelLoadWord(&buf[i]));
+    }
+    Programmer_startDelay(0);
+    while (i < count) {
+        Programmer_waitDelay();
+        parallelCommitWrite();
+        Programmer_startDelay(Timing.addressSetup);
+        Programmer_waitDelay();
+
+        Programmer_toggleCE(0);
+        Programmer_startDelay(pulseWidth);
+        last = i;
+        i = parallelNextWrite(buf, current, i + DataBytes, count);
+        if (i < count) {
+            parallelStageWrite(address + i, parallelLoadWord(&buf[i]));
+        }
+        Programmer_waitDelay();
+        Programmer_toggleCE(1);
+        Programmer_startDelay(WriteRecoveryTime);
+    }
+    Programmer_waitDelay();
+
+    return last;
+}
+
+OPEN_EEPROM_RAMFUNC static void parallelWriteBytes(uint32_t address, const char *buf, size_t count) {
+    Programmer_toggleDataIOMode(1);
+    Programmer_toggleOE(1);
+    Programmer_toggleWE(0);
+    parallelWriteRun(address, buf, count, WritePulseTime, NULL);
+    Programmer_toggleWE(1);
+    Programmer_toggleDataIOMode(0);
+}
+
+/* Write one page at a time. When skipping unchanged bytes the page is read
+   first so that only changed bytes cost a write cycle, and when verifying it
+   is read back afterwards and the bytes that did not take are retried with
+   longer pulses. */
+static int parallelWritePages(uint32_t address, const char *buf, size_t count) {
+    int onlyChanged = CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED;
+    int verify = CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY;
+    uint32_t pageSize = CurrentPageSize < DataBytes ? DataBytes : CurrentPageSize;
+
+    while (count > 0) {
+        size_t chunk = pageSize - (address & (pageSize - 1));
+        if (chunk > count) {
+            chunk = count;
+        }
+
+        if (onlyChanged) {
+            parallelReadBytes(address, PageBuf, chunk);
+        }
+
+        /* A byte that never takes also never finishes data polling, 
+           so when verifying let the read back decide instead. */
+        uint32_t pulseWidth = WritePulseTime;
+        if (!parallelProgramPage(address, buf, chunk, pulseWidth, onlyChanged) && !verify) {
+            return 0;
+        }
+
+        for (uint8_t attempt = 0; verify; attempt++) {
+            parallelReadBytes(address, PageBuf, chunk);
+
+            size_t mismatches = 0;
+            for (size_t i = 0; i < chunk; i++) {
+                mismatches += PageBuf[i] != buf[i];
+            }
+
+            if (mismatches == 0) {
+                break;
+            } else if (attempt == WriteRetries) {
+                for (size_t i = 0; i < chunk; i++) {
+                    if (PageBuf[i] != buf[i]) {
+                        recordWriteFailure(address + i);
+                    }
+                }
+                break;
+            }
+
+            pulseWidth += RetryPulseWidthStep;
+            parallelProgramPage(address, buf, chunk, pulseWidth, 1);
+        }
+
+        address += chunk;
+        buf += chunk;
+        count -= chunk;
+    }
+    return 1;
+}
+
+/* Write the bytes of a page and wait for the chip to finish. If onlyChanged
+   is set, bytes that PageBuf shows already hold the new value are skipped. */
+OPEN_EEPROM_RAMFUNC static int parallelProgramPage(uint32_t address, const char *buf, size_t count, uint32_t pulseWidth, int onlyChanged) {
+    size_t last = parallelStartPage(address, buf, count, pulseWidth, onlyChanged ? PageBuf : NULL);
+    return last == count || parallelWaitWriteComplete(address + last, parallelLoadWord(&buf[last]));
+}
+
+/* Write the words of a page without waiting for the chip. Returns the 
+   index of the last word written, which data polling then waits on. */
+OPEN_EEPROM_RAMFUNC static size_t parallelStartPage(uint32_t address, const char *buf, size_t count, uint32_t pulseWidth, const char *current) {
+    size_t last;
+
+    Programmer_toggleDataIOMode(1);
+    Programmer_toggleWE(0);
+    last = parallelWriteRun(address, buf, count, pulseWidth, current);
+    Programmer_toggleWE(1);
+    Programmer_toggleDataIOMode(0);
+
+    return last;
+}
+
+/* One program pulse lasting `pulses` pulse widths. OE# stays high, 
+   and with a PGM# line CE# is held low around the pulse. */
+static void parallelEpromPulse(uint32_t address, uint16_t data, uint32_t pulses) {
+    int pgm = EpromPulseLine == OPEN_EEPROM_EPROM_PULSE_PGM;
+
+    Programmer_toggleOE(1);
+    Programmer_toggleDataIOMode(1);
+    parallelSetAddress(parallelBusAddress(address));
+    Programmer_setData(data);
+    Programmer_toggleCE(!pgm);
+    parallelDelay(Timing.addressSetup > Timing.dataSetup ? Timing.addressSetup : Timing.dataSetup);
+
+    if (pgm) {
+        Programmer_togglePGM(0);
     } else {
-        if (Programmer_spiTransmit(&in[sizeof(uint8_t) + sizeof(count)], &out[sizeof(OpenEEPROM_ACK)], count)) {
-            out[0] = OpenEEPROM_ACK;
-            response_len += count;
-        } else {
-            out[0] = OpenEEPROM_NAK; 
+        Programmer_toggleCE(0);
+    }
+    for (uint32_t i = 0; i < pulses; i++) {
+        parallelDelay(EpromPulseWidth);
+    }
+    if (pgm) {
+        Programmer_togglePGM(1);
+    } else {
+        Programmer_toggleCE(1);
+    }
+
+    parallelDelay(Timing.dataHold);
+    Programmer_toggleCE(1);
+    Programmer_toggleDataIOMode(0);
+}
+
+/* Quick-pulse programming: pulse and verify each word until it reads 
+   back, then overprogram it in proportion to the pulses it needed. */
+static void parallelProgramEprom(uint32_t address, const char *buf, size_t count) {
+    char current[2];
+
+    for (size_t i = 0; i < count; i += DataBytes) {
+        uint16_t data = parallelLoadWord(&buf[i]);
+        uint16_t read;
+        uint32_t pulses = 0;
+
+        parallelReadBytes(address + i, current, DataBytes);
+        read = parallelLoadWord(current);
+        if ((read & data) != data) {
+            recordWriteFailure(address + i);
+            continue;
+        }
+
+        while (read != data && pulses < EpromMaxPulses) {
+            parallelEpromPulse(address + i, data, 1);
+            pulses++;
+            parallelReadBytes(address + i, current, DataBytes);
+            read = parallelLoadWord(current);
+        }
+
+        if (read != data) {
+            recordWriteFailure(address + i);
+        } else if (pulses > 0 && EpromOverprogram > 0) {
+            parallelEpromPulse(address + i, data, pulses * EpromOverprogram);
         }
     }
+}
 
-    return response_len;
+static void parallelUpdateWriteTiming(void) {
+    uint32_t dataSetup = Timing.dataSetup > Timing.addressSetup ? Timing.dataSetup - Timing.addressSetup : 0;
+
+    WritePulseTime = Timing.writePulse;
+    if (Timing.addressHold > WritePulseTime) {
+        WritePulseTime = Timing.addressHold;
+    }
+    if (dataSetup > WritePulseTime) {
+        WritePulseTime = dataSetup;
+    }
+    WriteRecoveryTime = Timing.writePulseHigh > Timing.dataHold ? Timing.writePulseHigh : Timing.dataHold;
 }
 
-static inline int switchToParallelBusMode(void) {
-    if ((CurrentBusMode != OPEN_EEPROM_BUS_MODE_PARALLEL) && 
-            (OPEN_EEPROM_BUS_MODE_PARALLEL & SupportedBusTypes)) {
-        Programmer_initParallel();
-        return 1;
+static int parallelSetAddressBusWidth(uint8_t busWidth) {
+    int nativeWidth;
+
+    if (busWidth <= Programmer_getAddressPinCount()) {
+        Programmer_setAddressExtender(0);
+        nativeWidth = busWidth;
     } else {
+        nativeWidth = Programmer_setAddressExtender(1);
+        if (nativeWidth == 0 || busWidth > nativeWidth + Programmer_getAddressExtenderWidth()) {
+            Programmer_setAddressExtender(CurrentAddressBusWidth > NativeAddressWidth);
+            return 0;
+        }
+    }
+
+    CurrentAddressBusWidth = busWidth;
+    NativeAddressWidth = nativeWidth;
+    UpperAddress = UINT32_MAX;
+    if (CurrentBusMode == OPEN_EEPROM_BUS_MODE_PARALLEL) {
+        Programmer_initParallel();
+    }
+    return 1;
+}
+
+static int parallelSetDataBusWidth(uint8_t busWidth) {
+    if (!Programmer_setDataBusWidth(busWidth)) {
         return 0;
     }
+    CurrentDataBusWidth = busWidth;
+    DataBytes = busWidth / 8;
+    return 1;
 }
 
-static inline int switchToSpiBusMode(void) {
-    if ((CurrentBusMode != OPEN_EEPROM_BUS_MODE_SPI) && 
-            (OPEN_EEPROM_BUS_MODE_SPI & SupportedBusTypes)) {
-        Programmer_initSpi();
+/* The programmer applies a new drive when it configures the pins, 
+   so reconfigure them if the parallel bus is already in use. */
+static int parallelSetPadDrive(uint8_t drive) {
+    if (!Programmer_setPadDrive(drive)) {
+        return 0;
+    }
+    CurrentPadDrive = drive;
+    if (CurrentBusMode == OPEN_EEPROM_BUS_MODE_PARALLEL) {
+        Programmer_initParallel();
+    }
+    return 1;
+}
+
+/* Compare repeated reads of a range against the reference in PageBuf. */
+static int parallelReadStable(uint32_t address, size_t count) {
+    for (int pass = 0; pass < OPEN_EEPROM_CALIBRATION_PASSES; pass++) {
+        parallelReadBytes(address, ScratchBuf, count);
+        for (size_t i = 0; i < count; i++) {
+            if (ScratchBuf[i] != PageBuf[i]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Data polling: while an internal write cycle is in progress the chip 
+   returns something other than the last byte written to it. */
+static int parallelWaitWriteComplete(uint32_t address, uint16_t data) {
+    char current[2];
+    for (uint32_t waited = 0; waited < OPEN_EEPROM_WRITE_CYCLE_TIMEOUT; 
+            waited += OPEN_EEPROM_WRITE_POLL_INTERVAL) {
+        parallelReadBytes(address, current, DataBytes);
+        if (parallelLoadWord(current) == data) {
+            return 1;
+        }
+        Programmer_delay1ns(OPEN_EEPROM_WRITE_POLL_INTERVAL);
+    }
+    return 0;
+}
+
+static inline size_t spiSetHeader(char *frame, uint8_t instruction, uint32_t address) {
+    frame[0] = instruction;
+    for (int i = OPEN_EEPROM_SPI_ADDRESS_BYTES; i > 0; i--) {
+        frame[i] = address & 0xFF;
+        address >>= 8;
+    }
+    return SPI_HEADER_SIZE;
+}
+
+static void spiReadBytes(uint32_t address, char *buf, size_t count) {
+    while (count > 0) {
+        size_t chunk = count < OPEN_EEPROM_PAGE_BUFFER_SIZE ? count : OPEN_EEPROM_PAGE_BUFFER_SIZE;
+        size_t header = spiSetHeader(SpiFrame, SPI_INSTRUCTION_READ, address);
+        Programmer_spiTransmit(SpiFrame, SpiFrame, header + chunk);
+        memcpy(buf, &SpiFrame[header], chunk);
+        address += chunk;
+        buf += chunk;
+        count -= chunk;
+    }
+}
+
+static int spiWaitReady(void) {
+    for (uint32_t waited = 0; waited < OPEN_EEPROM_WRITE_CYCLE_TIMEOUT; 
+            waited += OPEN_EEPROM_WRITE_POLL_INTERVAL) {
+        SpiFrame[0] = SPI_INSTRUCTION_READ_STATUS;
+        Programmer_spiTransmit(SpiFrame, SpiFrame, 2);
+        if ((SpiFrame[1] & SPI_STATUS_WIP) == 0) {
+            return 1;
+        }
+        Programmer_delay1ns(OPEN_EEPROM_WRITE_POLL_INTERVAL);
+    }
+    return 0;
+}
+
+static int spiProgramPage(uint32_t address, const char *buf, size_t count) {
+    spiStartPage(address, buf, count);
+    return spiWaitReady();
+}
+
+static void spiStartPage(uint32_t address, const char *buf, size_t count) {
+    SpiFrame[0] = SPI_INSTRUCTION_WRITE_ENABLE;
+    Programmer_spiTransmit(SpiFrame, SpiFrame, 1);
+
+    size_t header = spiSetHeader(SpiFrame, SPI_INSTRUCTION_PAGE_PROGRAM, address);
+    memcpy(&SpiFrame[header], buf, count);
+    Programmer_spiTransmit(SpiFrame, SpiFrame, header + count);
+}
+
+static int spiWritePages(uint32_t address, const char *buf, size_t count) {
+    while (count > 0) {
+        size_t chunk = CurrentPageSize - (address & (CurrentPageSize - 1));
+        if (chunk > count) {
+            chunk = count;
+        }
+
+        size_t first = 0, end = chunk;
+        if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_SKIP_UNCHANGED) {
+            spiReadBytes(address, PageBuf, chunk);
+            while (first < end && PageBuf[first] == buf[first]) {
+                first++;
+            }
+            while (end > first && PageBuf[end - 1] == buf[end - 1]) {
+                end--;
+            }
+        }
+
+        if (first < end && !spiProgramPage(address + first, &buf[first], end - first)) {
+            return 0;
+        }
+
+        if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY) {
+            spiReadBytes(address, PageBuf, chunk);
+            checkWrittenPage(address, buf, chunk);
+        }
+
+        address += chunk;
+        buf += chunk;
+        count -= chunk;
+    }
+    return 1;
+}
+
+/* Split an address into the word address sent to the chip and the
+   block-select bits that overflow into the device address. */
+static inline size_t i2cSetHeader(char *header, uint32_t address, uint8_t *device) {
+    *device = CurrentI2cAddress | ((address >> (8 * CurrentI2cAddressBytes)) & 0x07);
+    for (int i = CurrentI2cAddressBytes - 1; i >= 0; i--) {
+        header[i] = address & 0xFF;
+        address >>= 8;
+    }
+    return CurrentI2cAddressBytes;
+}
+
+static int i2cReadBytes(uint32_t address, char *buf, size_t count) {
+    char header[2];
+    uint8_t device;
+    uint32_t blockSize = 1UL << (8 * CurrentI2cAddressBytes);
+
+    while (count > 0) {
+        /* Sequential reads wrap within a block, so never cross one. */
+        size_t chunk = blockSize - (address & (blockSize - 1));
+        if (chunk > count) {
+            chunk = count;
+        }
+
+        size_t headerLen = i2cSetHeader(header, address, &device);
+        if (!Programmer_i2cTransfer(device, header, headerLen, buf, chunk)) {
+            return 0;
+        }
+
+        address += chunk;
+        buf += chunk;
+        count -= chunk;
+    }
+    return 1;
+}
+
+static int i2cWritePages(uint32_t address, const char *buf, size_t count) {
+    while (count > 0) {
+        size_t chunk = CurrentPageSize - (address & (CurrentPageSize - 1));
+        if (chunk > count) {
+            chunk = count;
+        }
+        if (!i2cStartPage(address, buf, chunk) || !i2cWaitReady()) {
+            return 0;
+        }
+        if (CurrentWriteMode & OPEN_EEPROM_WRITE_MODE_VERIFY) {
+            if (!i2cReadBytes(address, PageBuf, chunk)) {
+                return 0;
+            }
+            checkWrittenPage(address, buf, chunk);
+        }
+        address += chunk;
+        buf += chunk;
+        count -= chunk;
+    }
+    return 1;
+}
+
+/* A page write must not cross a page, or it wraps to the page start. */
+static int i2cStartPage(uint32_t address, const char *buf, size_t count) {
+    uint8_t device;
+    size_t header = i2cSetHeader(SpiFrame, address, &device);
+    memcpy(&SpiFrame[header], buf, count);
+    return Programmer_i2cTransfer(device, SpiFrame, header + count, NULL, 0);
+}
+
+/* Acknowledge polling: the chip ignores its address until the
+   internal write cycle is over. */
+static int i2cWaitReady(void) {
+    char data;
+    for (uint32_t waited = 0; waited < OPEN_EEPROM_WRITE_CYCLE_TIMEOUT; 
+            waited += OPEN_EEPROM_WRITE_POLL_INTERVAL) {
+        if (Programmer_i2cTransfer(CurrentI2cAddress, NULL, 0, &data, 1)) {
+            return 1;
+        }
+        Programmer_delay1ns(OPEN_EEPROM_WRITE_POLL_INTERVAL);
+    }
+    return 0;
+}
+
+static int loadProfile(uint8_t slot, struct ChipProfile *profile) {
+    uint32_t offset = slot * sizeof(*profile);
+
+    if (slot >= OPEN_EEPROM_PROFILE_COUNT || offset + sizeof(*profile) > Programmer_getStorageSize()) {
+        return 0;
+    }
+    return Programmer_readStorage(offset, (char *) profile, sizeof(*profile)) && profile->magic == PROFILE_MAGIC;
+}
+
+/* Restore every setting first, then bring up the profile's bus with them. */
+static int applyProfile(const struct ChipProfile *profile) {
+    uint32_t pageSize = profile->pageSize;
+
+    if (pageSize == 0 || pageSize > OPEN_EEPROM_PAGE_BUFFER_SIZE || (pageSize & (pageSize - 1)) != 0
+            || !parallelSetAddressBusWidth(profile->addressBusWidth)) {
+        return 0;
+    }
+
+    if (!parallelSetPadDrive(profile->padDrive)
+            || (profile->dataBusWidth != 0 && !parallelSetDataBusWidth(profile->dataBusWidth))) {
+        return 0;
+    }
+    Timing = profile->timing;
+    parallelUpdateWriteTiming();
+    CurrentWriteMode = profile->writeMode;
+    CurrentPageSize = pageSize;
+    if (profile->readPageSize != 0) {
+        ReadPageSize = profile->readPageSize;
+        PageAccessTime = profile->pageAccessTime;
+    }
+    CurrentI2cAddress = profile->i2cAddress;
+    CurrentI2cAddressBytes = profile->i2cAddressBytes;
+
+    switch (profile->busMode) {
+        case OPEN_EEPROM_BUS_MODE_PARALLEL:
+            return switchToParallelBusMode();
+        case OPEN_EEPROM_BUS_MODE_SPI:
+            if (!switchToSpiBusMode() || !Programmer_setSpiMode(profile->spiMode)
+                    || !Programmer_setSpiClockFreq(profile->spiFrequency)) {
+                return 0;
+            }
+            CurrentSpiMode = profile->spiMode;
+            CurrentSpiFrequency = profile->spiFrequency;
+            return 1;
+        case OPEN_EEPROM_BUS_MODE_I2C:
+            return switchToI2cBusMode();
+        default:
+            return 1;
+    }
+}
+
+static int loadImageHeader(struct ImageHeader *header) {
+    return Programmer_getImageStoreSize() > sizeof(*header) 
+        && Programmer_readImageStore(0, (char *) header, sizeof(*header)) 
+        && header->magic == IMAGE_MAGIC;
+}
+
+static void imageOpen(struct ImageReader *reader, const struct ImageHeader *header) {
+    reader->offset = sizeof(*header);
+    reader->end = sizeof(*header) + header->packedSize;
+    reader->run = 0;
+}
+
+/* Expand the next count bytes of a PackBits image. Fails if
+   the compressed data ends first. */
+static int imageRead(struct ImageReader *reader, char *buf, size_t count) {
+    while (count > 0) {
+        if (reader->run == 0) {
+            int8_t header;
+            if (reader->offset >= reader->end || !Programmer_readImageStore(reader->offset++, (char *) &header, 1)) {
+                return 0;
+            }
+            if (header >= 0) {
+                reader->run = header + 1;
+                reader->repeat = 0;
+            } else if (header != -128) {
+                reader->run = 1 - header;
+                reader->repeat = 1;
+                if (reader->offset >= reader->end || !Programmer_readImageStore(reader->offset++, &reader->value, 1)) {
+                    return 0;
+                }
+            }
+            continue;
+        }
+
+        size_t n = reader->run < count ? reader->run : count;
+        if (reader->repeat) {
+            for (size_t i = 0; i < n; i++) {
+                buf[i] = reader->value;
+            }
+        } else {
+            if (reader->offset + n > reader->end || !Programmer_readImageStore(reader->offset, buf, n)) {
+                return 0;
+            }
+            reader->offset += n;
+        }
+        buf += n;
+        count -= n;
+        reader->run -= n;
+    }
+    return 1;
+}
+
+/* Start a program job on each press of the trigger. */
+static void standalonePoll(void) {
+    if (!StandaloneLoaded) {
+        if (STANDALONE_OFFSET + sizeof(Standalone) > Programmer_getStorageSize() ||
+                !Programmer_readStorage(STANDALONE_OFFSET, (char *) &Standalone, sizeof(Standalone)) ||
+                Standalone.magic != STANDALONE_MAGIC) {
+            Standalone.enabled = 0;
+        }
+        StandaloneLoaded = 1;
+    }
+    if (!Standalone.enabled) {
+        return;
+    }
+
+    int pressed = Programmer_getTrigger();
+    if (pressed && !TriggerPressed && loadProfile(Standalone.slot, &Profile) && applyProfile(&Profile)) {
+        struct Job job = {0};
+        job.type = OPEN_EEPROM_JOB_PROGRAM_IMAGE;
+        job.bus = Profile.busMode;
+        job.address = Standalone.address;
+        jobStart(&job);
+    }
+    TriggerPressed = pressed;
+}
+
+/* A JEDEC ID of all zeros or all ones means nothing drove MISO. */
+static int spiProbe(uint32_t *id) {
+    if (!switchToSpiBusMode() || !Programmer_setSpiMode(OPEN_EEPROM_SPI_MODE_0)
+            || !Programmer_setSpiClockFreq(OPEN_EEPROM_PROBE_SPI_FREQ)) {
+        return 0;
+    }
+    CurrentSpiMode = OPEN_EEPROM_SPI_MODE_0;
+    CurrentSpiFrequency = OPEN_EEPROM_PROBE_SPI_FREQ;
+
+    SpiFrame[0] = SPI_INSTRUCTION_READ_JEDEC_ID;
+    SpiFrame[1] = SpiFrame[2] = SpiFrame[3] = 0;
+    Programmer_spiTransmit(SpiFrame, SpiFrame, 4);
+    *id = (uint8_t) SpiFrame[1] << 16 | (uint8_t) SpiFrame[2] << 8 | (uint8_t) SpiFrame[3];
+
+    return *id != 0 && *id != 0xFFFFFF;
+}
+
+/* A current address read is harmless to any I2C memory, so it is used to
+   find the first address that answers and how many follow it. 24C04 to 
+   24C16 take the upper address bits in the device address and answer on 
+   2, 4 or 8 addresses; larger chips answer on one and use 2 address bytes. */
+static int i2cProbe(uint32_t *id) {
+    uint8_t base = OPEN_EEPROM_I2C_DEFAULT_ADDRESS;
+    uint32_t span = 0;
+    char data;
+
+    if (!switchToI2cBusMode()) {
+        return 0;
+    }
+
+    while (base < OPEN_EEPROM_I2C_DEFAULT_ADDRESS + I2C_PROBE_ADDRESS_COUNT
+            && !Programmer_i2cTransfer(base, NULL, 0, &data, 1)) {
+        base++;
+    }
+    while (base + span < OPEN_EEPROM_I2C_DEFAULT_ADDRESS + I2C_PROBE_ADDRESS_COUNT
+            && Programmer_i2cTransfer(base + span, NULL, 0, &data, 1)) {
+        span++;
+    }
+    if (span == 0) {
+        return 0;
+    }
+
+    uint8_t addressBytes = i2cProbeAddressBytes(base);
+    CurrentI2cAddress = base;
+    CurrentI2cAddressBytes = addressBytes != 0 ? addressBytes : 1;
+    CurrentPageSize = 1;
+    *id = span | (uint32_t) addressBytes << 8;
+    return 1;
+}
+
+/* Tell one address byte from two by which of them reads the chip
+   consistently. Returns 0 if both or neither do. */
+static uint8_t i2cProbeAddressBytes(uint8_t device) {
+    int fitsOne, fitsTwo;
+
+    if (!i2cProbeFits(device, 1, &fitsOne) || !i2cProbeFits(device, 2, &fitsTwo) || fitsOne == fitsTwo) {
+        return 0;
+    }
+    return fitsOne ? 1 : 2;
+}
+
+/* Read two windows from address 0 and one from the start of the second
+   window, sending the address in addressBytes bytes. With the right
+   count, the single window matches the second of the two and, unless the
+   contents repeat, differs from the first. With too many, the chip takes
+   the extra byte as data, and with too few it keeps part of its old 
+   address, so the reads do not line up. The address is followed by a 
+   repeated start rather than a stop, so a byte taken as data is never
+   programmed. */
+static int i2cProbeFits(uint8_t device, uint8_t addressBytes, int *fits) {
+    char address[2] = {0, 0};
+    char whole[2 * I2C_PROBE_WINDOW], half[I2C_PROBE_WINDOW];
+    int second = 1, first = 1;
+
+    if (!Programmer_i2cTransfer(device, address, addressBytes, whole, sizeof(whole))) {
+        return 0;
+    }
+    address[addressBytes - 1] = I2C_PROBE_WINDOW;
+    if (!Programmer_i2cTransfer(device, address, addressBytes, half, sizeof(half))) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < I2C_PROBE_WINDOW; i++) {
+        second &= half[i] == whole[I2C_PROBE_WINDOW + i];
+        first &= half[i] == whole[i];
+    }
+    *fits = second && !first;
+    return 1;
+}
+
+static void parallelSendCommand(uint8_t command) {
+    Programmer_toggleDataIOMode(1);
+    Programmer_toggleOE(1);
+    Programmer_toggleWE(0);
+    parallelWriteCycle(0x5555, 0xAA, WritePulseTime);
+    parallelWriteCycle(0x2AAA, 0x55, WritePulseTime);
+    parallelWriteCycle(0x5555, command, WritePulseTime);
+    Programmer_toggleWE(1);
+    Programmer_toggleDataIOMode(0);
+    Programmer_delay1ns(PARALLEL_PRODUCT_ID_DELAY);
+}
+
+/* In product ID mode a chip returns its manufacturer and device bytes at
+   addresses 0 and 1. If those match the array contents there is either no 
+   chip or one without the mode, such as a mask ROM or UV EPROM. The
+   parallel settings are put back if no chip answers. */
+static int parallelProbe(uint32_t *id) {
+    char array[2], product[2];
+    struct OpenEEPROM_ParallelTiming timing = Timing;
+    uint8_t dataBusWidth = CurrentDataBusWidth;
+    uint8_t addressBusWidth = CurrentAddressBusWidth;
+
+    if (!switchToParallelBusMode() || !parallelSetDataBusWidth(8)) {
+        return 0;
+    }
+    if (!parallelSetAddressBusWidth(Programmer_getAddressPinCount())) {
+        parallelSetDataBusWidth(dataBusWidth);
+        return 0;
+    }
+    Timing = (struct OpenEEPROM_ParallelTiming) {
+        .addressSetup = OPEN_EEPROM_PROBE_ACCESS_TIME,
+        .addressAccess = OPEN_EEPROM_PROBE_ACCESS_TIME,
+        .outputEnable = OPEN_EEPROM_PROBE_ACCESS_TIME,
+        .writePulse = OPEN_EEPROM_PROBE_PULSE_WIDTH,
+        .writePulseHigh = OPEN_EEPROM_PROBE_PULSE_WIDTH,
+    };
+    parallelUpdateWriteTiming();
+
+    parallelReadBytes(0, array, sizeof(array));
+    parallelSendCommand(PARALLEL_COMMAND_PRODUCT_ID_ENTRY);
+    parallelReadBytes(0, product, sizeof(product));
+    parallelSendCommand(PARALLEL_COMMAND_PRODUCT_ID_EXIT);
+
+    *id = (uint8_t) product[0] << 8 | (uint8_t) product[1];
+    if ((product[0] != array[0] || product[1] != array[1]) 
+            && product[0] != 0 && product[0] != (char) 0xFF) {
         return 1;
-    } else {
+    }
+
+    Timing = timing;
+    parallelUpdateWriteTiming();
+    parallelSetDataBusWidth(dataBusWidth);
+    parallelSetAddressBusWidth(addressBusWidth);
+    return 0;
+}
+
+/* Check a job can run, then make it the current job. */
+static int jobStart(struct Job *job) {
+    struct ImageHeader header;
+    int valid;
+
+    if (Job.state == OPEN_EEPROM_JOB_STATE_RUNNING) {
+        return 0;
+    }
+
+    switch (job->type) {
+        case OPEN_EEPROM_JOB_CHIP_ERASE:
+            valid = jobStartErase(job->bus);
+            break;
+        case OPEN_EEPROM_JOB_VERIFY:
+            job->checksumType = OPEN_EEPROM_CHECKSUM_CRC32;
+            /* fall through */
+        case OPEN_EEPROM_JOB_CHECKSUM:
+            /* An empty read checks the bus and alignment up front. */
+            valid = checksumStart(job->checksumType, &job->checksum)
+                && readMemory(job->bus, job->address, ScratchBuf, 0)
+                && (job->bus != OPEN_EEPROM_BUS_MODE_PARALLEL || parallelAligned(job->address, job->count));
+            break;
+        case OPEN_EEPROM_JOB_UPDATE_IMAGE:
+            if (job->bus != OPEN_EEPROM_BUS_MODE_SPI || job->address % SPI_SECTOR_SIZE != 0) {
+                valid = 0;
+                break;
+            }
+            /* fall through */
+        case OPEN_EEPROM_JOB_PROGRAM_IMAGE:
+            valid = loadImageHeader(&header) 
+                && writeMemory(job->bus, job->address, ScratchBuf, 0)
+                && (job->bus != OPEN_EEPROM_BUS_MODE_PARALLEL || parallelAligned(job->address, header.size));
+            if (!valid) {
+                break;
+            }
+            job->checksumType = OPEN_EEPROM_CHECKSUM_CRC32;
+            checksumStart(job->checksumType, &job->checksum);
+            job->count = header.size;
+            job->expected = header.crc;
+            imageOpen(&ImageReader, &header);
+            SectorReader = ImageReader;
+            break;
+        default:
+            valid = 0;
+    }
+
+    if (!valid) {
+        return 0;
+    }
+
+    job->id = Job.id + 1 == 0 ? 1 : Job.id + 1;
+    job->state = OPEN_EEPROM_JOB_STATE_RUNNING;
+    job->started = Programmer_getTicks();
+    Job = *job;
+    return 1;
+}
+
+/* Expand and write up to one page buffer of the staged image, 
+   ending each slice on a page buffer boundary. */
+static void jobProgramSlice(void) {
+    uint32_t address = Job.address + Job.programmed;
+    uint32_t remaining = Job.count - Job.programmed;
+    size_t chunk = sizeof(ScratchBuf) - (address % sizeof(ScratchBuf));
+    if (chunk > remaining) {
+        chunk = remaining;
+    }
+
+    if (!imageRead(&ImageReader, ScratchBuf, chunk) || !writeMemory(Job.bus, address, ScratchBuf, chunk)) {
+        jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        return;
+    }
+    Job.programmed += chunk;
+}
+
+/* Take the staged image a slice of one sector further. Planning
+   compares the sector with the image up to the first bit that must 
+   go from 0 to 1, after which the image is read again from the start
+   of the sector for programming. */
+static void jobUpdateSlice(void) {
+    uint32_t sector = Job.address + Job.programmed;
+    uint32_t sectorLen = Job.count - Job.programmed < SPI_SECTOR_SIZE ? Job.count - Job.programmed : SPI_SECTOR_SIZE;
+    uint32_t remaining = sectorLen - Job.sectorOffset;
+    size_t chunk = remaining < sizeof(ScratchBuf) ? remaining : sizeof(ScratchBuf);
+    char *current = CopyBuf[0];
+    size_t i;
+
+    if (Job.sectorPhase == SECTOR_ERASE) {
+        if (jobEraseDone()) {
+            Job.sectorPhase = SECTOR_PROGRAM;
+        } else if ((Programmer_getTicks() - Job.sectorStarted) / (Programmer_TicksPerSecond / 1000) 
+                > OPEN_EEPROM_SECTOR_ERASE_TIMEOUT) {
+            jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        }
+        return;
+    }
+
+    if (!imageRead(&ImageReader, ScratchBuf, chunk) || !readMemory(Job.bus, sector + Job.sectorOffset, current, chunk)) {
+        jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        return;
+    }
+
+    if (Job.sectorPhase == SECTOR_PLAN) {
+        for (i = 0; i < chunk && Job.sectorClass != SECTOR_NEEDS_ERASE; i++) {
+            if (ScratchBuf[i] & ~current[i]) {
+                Job.sectorClass = SECTOR_NEEDS_ERASE;
+            } else if (ScratchBuf[i] != current[i]) {
+                Job.sectorClass = SECTOR_PROGRAM_ONLY;
+            }
+        }
+        Job.sectorOffset += chunk;
+        if (Job.sectorOffset < sectorLen && Job.sectorClass != SECTOR_NEEDS_ERASE) {
+            return;
+        }
+
+        if (Job.sectorClass == SECTOR_UNCHANGED) {
+            Job.programmed += sectorLen;
+            Job.sectorOffset = 0;
+            SectorReader = ImageReader;
+            return;
+        }
+
+        ImageReader = SectorReader;
+        Job.sectorOffset = 0;
+        if (Job.sectorClass == SECTOR_PROGRAM_ONLY) {
+            Job.sectorPhase = SECTOR_PROGRAM;
+            return;
+        }
+
+        SpiFrame[0] = SPI_INSTRUCTION_WRITE_ENABLE;
+        Programmer_spiTransmit(SpiFrame, SpiFrame, 1);
+        Programmer_spiTransmit(SpiFrame, SpiFrame, spiSetHeader(SpiFrame, SPI_INSTRUCTION_SECTOR_ERASE, sector));
+        Job.sectorStarted = Programmer_getTicks();
+        Job.sectorPhase = SECTOR_ERASE;
+        return;
+    }
+
+    for (i = 0; i < chunk && ScratchBuf[i] == current[i]; i++)
+        ;
+    if (i < chunk && !writeMemory(Job.bus, sector + Job.sectorOffset, ScratchBuf, chunk)) {
+        jobFinish(OPEN_EEPROM_JOB_STATE_FAILED);
+        return;
+    }
+    Job.sectorOffset += chunk;
+
+    if (Job.sectorOffset == sectorLen) {
+        Job.programmed += sectorLen;
+        Job.sectorOffset = 0;
+        Job.sectorPhase = SECTOR_PLAN;
+        Job.sectorClass = SECTOR_UNCHANGED;
+        SectorReader = ImageReader;
+    }
+}
+
+/* Issue a chip erase and return without waiting for it. */
+static int jobStartErase(uint8_t bus) {
+    switch (bus) {
+        case OPEN_EEPROM_BUS_MODE_PARALLEL:
+            if (Timing.addressAccess < Programmer_MinimumDelay || 
+                    Timing.writePulse < Programmer_MinimumDelay ||
+                    !switchToParallelBusMode()) {
+                return 0;
+            }
+            parallelSendCommand(PARALLEL_COMMAND_ERASE_SETUP);
+            parallelSendCommand(PARALLEL_COMMAND_CHIP_ERASE);
+            return 1;
+
+        case OPEN_EEPROM_BUS_MODE_SPI:
+            if (!switchToSpiBusMode()) {
+                return 0;
+            }
+            SpiFrame[0] = SPI_INSTRUCTION_WRITE_ENABLE;
+            Programmer_spiTransmit(SpiFrame, SpiFrame, 1);
+            SpiFrame[0] = SPI_INSTRUCTION_CHIP_ERASE;
+            Programmer_spiTransmit(SpiFrame, SpiFrame, 1);
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+/* Poll an erasing chip once: serial flash clears WIP when done, 
+   and parallel chips return the erased value to data polling. */
+static int jobEraseDone(void) {
+    char current[2];
+
+    if (Job.bus == OPEN_EEPROM_BUS_MODE_SPI) {
+        SpiFrame[0] = SPI_INSTRUCTION_READ_STATUS;
+        Programmer_spiTransmit(SpiFrame, SpiFrame, 2);
+        return (SpiFrame[1] & SPI_STATUS_WIP) == 0;
+    }
+    parallelReadBytes(0, current, DataBytes);
+    return parallelLoadWord(current) == (DataBytes == 1 ? 0xFF : 0xFFFF);
+}
+
+static void jobFinish(uint8_t state) {
+    Job.elapsed = (Programmer_getTicks() - Job.started) / (Programmer_TicksPerSecond / 1000);
+    Job.state = state;
+}
+
+static uint8_t jobProgress(void) {
+    uint32_t done = Job.programmed + Job.done;
+    uint32_t total = Job.type == OPEN_EEPROM_JOB_PROGRAM_IMAGE || Job.type == OPEN_EEPROM_JOB_UPDATE_IMAGE ? 
+        2 * Job.count : Job.count;
+
+    if (Job.state == OPEN_EEPROM_JOB_STATE_DONE) {
+        return 100;
+    } else if (total == 0) {
         return 0;
     }
+    return total < UINT32_MAX / 100 ? done * 100 / total : done / (total / 100);
 }
 
+static void recordWriteFailure(uint32_t address) {
+    if (WriteFailureCount < OPEN_EEPROM_MAX_REPORTED_FAILURES) {
+        WriteFailures[WriteFailureCount] = address;
+    }
+    WriteFailureCount++;
+}
+
+/* Record the bytes of a page read back into PageBuf that differ from buf. */
+static void checkWrittenPage(uint32_t address, const char *buf, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (PageBuf[i] != buf[i]) {
+            recordWriteFailure(address + i);
+        }
+    }
+}
+
+/* Write the failure count followed by as many failing addresses as were kept. */
+static size_t reportWriteFailures(char *out) {
+    size_t reported = WriteFailureCount < OPEN_EEPROM_MAX_REPORTED_FAILURES ? 
+        WriteFailureCount : OPEN_EEPROM_MAX_REPORTED_FAILURES;
+    memcpy(out, &WriteFailureCount, sizeof(WriteFailureCount));
+    memcpy(&out[sizeof(WriteFailureCount)], WriteFailures, reported * sizeof(WriteFailures[0]));
+    return sizeof(WriteFailureCount) + reported * sizeof(WriteFailures[0]);
+}
@@ -12,59 +12,133 @@
  */
 
 #include "open-eeprom.h"
+#include "open-eeprom_conf.h"
 #include "open-eeprom_server.h"
 #include "programmer.h"
 #include "transport.h"
 #include "string.h"
 
 static char *RxBuf;
-static char *TxBuf;
 static size_t RxBufSize;
 static size_t TxBufSize;
 
-static int (*Commands[])(const char *in, char *out) = {
-    OpenEEPROM_nop,
-    OpenEEPROM_sync,
-    OpenEEPROM_getInterfaceVersion,
-    OpenEEPROM_getMaxRxSize,
-    OpenEEPROM_getMaxTxSize,
-    OpenEEPROM_toggleIO,
-    OpenEEPROM_getSupportedBusTypes,
-    OpenEEPROM_setAddressBusWidth,
-    OpenEEPROM_setAddressHoldTime,
-    OpenEEPROM_setAddressPulseWidthTime,
-    OpenEEPROM_parallelRead,
-    OpenEEPROM_parallelWrite,
-    OpenEEPROM_setSpiFrequency,
-    OpenEEPROM_setSpiMode,
-    OpenEEPROM_getSupportedSpiModes,
-    OpenEEPROM_spiTransmit,
+/**
+ * @enum FramePayload
+ *
+ * Where the variable-length part of a command's frame travels.
+ */
+enum FramePayload {
+    FRAME_PAYLOAD_NONE,
+    FRAME_PAYLOAD_IN,       /**< n units follow the request header */
+    FRAME_PAYLOAD_OUT,      /**< n units follow the response status */
+    FRAME_PAYLOAD_INOUT,    /**< n units in both directions, answered in place */
+    FRAME_PAYLOAD_GATHER,   /**< n extents follow the request header, their data the response status */
+    FRAME_PAYLOAD_SCATTER,  /**< n extents follow the request header, then their data */
 };
 
-static int parseCommand(void);
+/* An extent is a 32-bit address followed by a 32-bit length. */
+#define EXTENT_SIZE 8
 
 /**
- * @brief Initialize the internal state of the OpenEEPROM server.
+ * @struct
+ * Frame layout of a command.
  *
- * Initialize the receive and transmit buffers and their sizes.
- * These buffers should be defined in the calling code.
+ * The header is the fixed part of the request, including the 
+ * command byte. Commands with a payload carry its length n as a
+ * 32-bit field at `lenOffset` within the header, counted in units 
+ * of `unit` bytes.
+ */
+typedef struct {
+    int (*handler)(const char *in, char *out);
+    uint8_t headerLen;
+    uint8_t lenOffset;
+    uint8_t payload;
+    uint8_t unit;
+} CommandFrame;
+
+static const CommandFrame Commands[] = {
+    [OPEN_EEPROM_CMD_NOP]                       = {OpenEEPROM_nop, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SYNC]                      = {OpenEEPROM_sync, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_GET_INTERFACE_VERSION]     = {OpenEEPROM_getInterfaceVersion, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_GET_MAX_RX_SIZE]           = {OpenEEPROM_getMaxRxSize, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_GET_MAX_TX_SIZE]           = {OpenEEPROM_getMaxTxSize, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_TOGGLE_IO]                 = {OpenEEPROM_toggleIO, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_GET_SUPPORTED_BUS_TYPES]   = {OpenEEPROM_getSupportedBusTypes, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_ADDRESS_BUS_WIDTH]     = {OpenEEPROM_setAddressBusWidth, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_ADDRESS_HOLD_TIME]     = {OpenEEPROM_setAddressHoldTime, 5, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_PULSE_WIDTH_TIME]      = {OpenEEPROM_setAddressPulseWidthTime, 5, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_PARALLEL_READ]             = {OpenEEPROM_parallelRead, 9, 5, FRAME_PAYLOAD_OUT, 1},
+    [OPEN_EEPROM_CMD_PARALLEL_WRITE]            = {OpenEEPROM_parallelWrite, 9, 5, FRAME_PAYLOAD_IN, 1},
+    [OPEN_EEPROM_CMD_SET_SPI_CLOCK_FREQ]        = {OpenEEPROM_setSpiFrequency, 5, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_SPI_MODE]              = {OpenEEPROM_setSpiMode, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_GET_SUPPORTED_SPI_MODES]   = {OpenEEPROM_getSupportedSpiModes, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SPI_TRANSMIT]              = {OpenEEPROM_spiTransmit, 5, 1, FRAME_PAYLOAD_INOUT, 1},
+    [OPEN_EEPROM_CMD_SET_WRITE_MODE]            = {OpenEEPROM_setWriteMode, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_PAGE_SIZE]             = {OpenEEPROM_setPageSize, 5, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SPI_WRITE]                 = {OpenEEPROM_spiWrite, 9, 5, FRAME_PAYLOAD_IN, 1},
+    [OPEN_EEPROM_CMD_CHECKSUM]                  = {OpenEEPROM_checksum, 11, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_I2C_ADDRESS]           = {OpenEEPROM_setI2cAddress, 3, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_BLANK_CHECK]               = {OpenEEPROM_blankCheck, 11, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_BLOCK_HASHES]              = {OpenEEPROM_blockHashes, 14, 10, FRAME_PAYLOAD_OUT, 4},
+    [OPEN_EEPROM_CMD_SET_WRITE_RETRIES]         = {OpenEEPROM_setWriteRetries, 6, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SAVE_PROFILE]              = {OpenEEPROM_saveProfile, 2 + OPEN_EEPROM_PROFILE_NAME_SIZE, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_LIST_PROFILES]             = {OpenEEPROM_listProfiles, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_APPLY_PROFILE]             = {OpenEEPROM_applyProfile, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_IDENTIFY]                  = {OpenEEPROM_identify, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_CALIBRATE_ADDRESS_HOLD_TIME] = {OpenEEPROM_calibrateAddressHoldTime, 13, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_PARALLEL_TIMING]       = {OpenEEPROM_setParallelTiming, 2 + sizeof(struct OpenEEPROM_ParallelTiming), 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_DATA_BUS_WIDTH]        = {OpenEEPROM_setDataBusWidth, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_PAGE_READ]             = {OpenEEPROM_setPageRead, 9, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_EPROM_PROGRAMMING]     = {OpenEEPROM_setEpromProgramming, 8, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_EPROM_PROGRAM]             = {OpenEEPROM_epromProgram, 9, 5, FRAME_PAYLOAD_IN, 1},
+    [OPEN_EEPROM_CMD_START_JOB]                 = {OpenEEPROM_startJob, 16, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_JOB_STATUS]                = {OpenEEPROM_jobStatus, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_JOB_ABORT]                 = {OpenEEPROM_jobAbort, 2, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_IMAGE_BEGIN]               = {OpenEEPROM_imageBegin, 9, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_IMAGE_WRITE]               = {OpenEEPROM_imageWrite, 5, 1, FRAME_PAYLOAD_IN, 1},
+    [OPEN_EEPROM_CMD_IMAGE_END]                 = {OpenEEPROM_imageEnd, 1, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_SET_STANDALONE]            = {OpenEEPROM_setStandalone, 7, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_COPY]                      = {OpenEEPROM_copy, 15, 0, FRAME_PAYLOAD_NONE, 0},
+    [OPEN_EEPROM_CMD_FILL]                      = {OpenEEPROM_fill, 14, 10, FRAME_PAYLOAD_IN, 1},
+    [OPEN_EEPROM_CMD_READ_EXTENTS]              = {OpenEEPROM_readExtents, 6, 2, FRAME_PAYLOAD_GATHER, EXTENT_SIZE},
+    [OPEN_EEPROM_CMD_WRITE_EXTENTS]             = {OpenEEPROM_writeExtents, 6, 2, FRAME_PAYLOAD_SCATTER, EXTENT_SIZE},
+    [OPEN_EEPROM_CMD_WRITE_BUFFERED]            = {OpenEEPROM_writeBuffered, 10, 6, FRAME_PAYLOAD_IN, 1},
+    [OPEN_EEPROM_CMD_FLUSH_WRITES]              = {OpenEEPROM_flushWrites, 1, 0, FRAME_PAYLOAD_NONE, 0},
+};
+
+#define COMMAND_COUNT (sizeof(Commands) / sizeof(Commands[0]))
+
+static const CommandFrame *parseCommand(size_t *requestLen);
+static int extentsFit(const char *extents, uint32_t count, size_t limit, size_t *total);
+static int allowedDuringJob(uint8_t cmd);
+
+/**
+ * @brief Initialize the internal state of the OpenEEPROM server.
  *
- * @param rxbuf buffer from which commands are read
- * 
- * @param maxRxSize size of rxbuf
+ * The server works out of a single transfer arena that 
+ * should be defined in the calling code. Each request is 
+ * read to the start of the arena and its response is 
+ * placed right after it, so a large request or a large 
+ * response can use nearly the whole arena.
  *
- * @param txbuf buffer to which responses are written
+ * The sizes reported by @ref OpenEEPROM_getMaxRxSize and 
+ * @ref OpenEEPROM_getMaxTxSize are the arena size less 
+ * OPEN_EEPROM_FRAME_RESERVE, which keeps room for the 
+ * fixed-size part of the other direction.
  *
- * @param maxTxSize size of txbuf
+ * @param arena buffer holding requests and responses
+ * 
+ * @param arenaSize size of arena
  *
  * @return 1 if successful, else 0
  */
-int OpenEEPROM_serverInit(char *rxbuf, size_t maxRxSize, char *txbuf, size_t maxTxSize) {
-    // TODO: error checking
-    RxBuf = rxbuf;
-    TxBuf = txbuf;
-    RxBufSize = maxRxSize;
-    TxBufSize = maxTxSize;
+int OpenEEPROM_serverInit(char *arena, size_t arenaSize) {
+    if (arena == NULL || arenaSize <= OPEN_EEPROM_FRAME_RESERVE) {
+        return 0;
+    }
+    RxBuf = arena;
+    RxBufSize = arenaSize - OPEN_EEPROM_FRAME_RESERVE;
+    TxBufSize = arenaSize - OPEN_EEPROM_FRAME_RESERVE;
     Programmer_init();
     Transport_init();
     return 1;
@@ -78,31 +152,51 @@ int OpenEEPROM_serverInit(char *rxbuf, size_t maxRxSize, char *txbuf, size_t max
  * it could be placed inside of a loop along with 
  * a function to enter a low-power sleep mode until 
  * an external event such as new data received.
+ * The caller should not sleep while a background
+ * job is running, since the job only advances 
+ * when no command is pending. A buffered write 
+ * that times out is likewise only flushed here.
  *
  * @return 1 if a valid command was received and run,
  *      or 0 if the command was invalid or no command
  *      was pending
  */
 int OpenEEPROM_serverTick(void) {
-    int validCmd = 0;
+    const CommandFrame *frame;
+    size_t requestLen = 0;
+    char *out = RxBuf;
     int response_len = 1;
 
     if (!Transport_dataWaiting()) {
+        OpenEEPROM_jobTick();
         return 0;
     }
 
-    validCmd = parseCommand();
-    
+    frame = parseCommand(&requestLen);
 
-    if (validCmd) {
-        response_len = OpenEEPROM_runCommand(RxBuf, TxBuf);
+    if (frame != NULL && OpenEEPROM_jobRunning() && !allowedDuringJob(RxBuf[0])) {
+        out = &RxBuf[requestLen];
+        out[0] = OpenEEPROM_NAK;
+    } else if (frame != NULL) {
+        if (RxBuf[0] != OPEN_EEPROM_CMD_WRITE_BUFFERED) {
+            OpenEEPROM_drainWrites();
+        }
+        /* Full-duplex commands answer in place: the status byte takes the 
+           last header byte and each returned byte replaces the byte it 
+           was exchanged for. Everything else answers after the request. */
+        if (frame->payload == FRAME_PAYLOAD_INOUT) {
+            out = &RxBuf[frame->headerLen - 1];
+        } else {
+            out = &RxBuf[requestLen];
+        }
+        response_len = OpenEEPROM_runCommand(RxBuf, out);
     } else {
-        TxBuf[0] = OpenEEPROM_NAK;
+        out[0] = OpenEEPROM_NAK;
     } 
 
-    Transport_putData(TxBuf, response_len);
+    Transport_putData(out, response_len);
 
-    return validCmd;
+    return frame != NULL;
 }
 
 /**
@@ -112,7 +206,8 @@ int OpenEEPROM_serverTick(void) {
  * buffer as a valid command, run it, and 
  * write the response to the output buffer.
  * 
- * This function does no input validation.
+ * Beyond rejecting unknown commands, this 
+ * function does no input validation.
  *
  * @param in a well-formed OpenEEPROM command
  *
@@ -121,15 +216,14 @@ int OpenEEPROM_serverTick(void) {
  * @return length in bytes of the response
  */
 size_t OpenEEPROM_runCommand(const char *in, char *out) {
-    enum OpenEEPROM_Command cmd;
-    size_t response_len = 0;
-    memcpy(&cmd, in, sizeof(cmd));
+    uint8_t cmd = in[0];
 
-    int (*func)(const char *in, char *out) = Commands[(uint8_t) cmd];
-
-    response_len = func(in, out);
+    if (cmd >= COMMAND_COUNT || Commands[cmd].handler == NULL) {
+        out[0] = OpenEEPROM_NAK;
+        return sizeof(OpenEEPROM_NAK);
+    }
 
-    return response_len;
+    return Commands[cmd].handler(in, out);
 }
 
 /**
@@ -175,16 +269,89 @@ int OpenEEPROM_getMaxTxSize(const char *in, char *out) {
     return sizeof(OpenEEPROM_ACK) + sizeof(TxBufSize);
 }
 
-static int parseCommand(void) {
-    unsigned int idx = 0;
+/* Read a command frame into RxBuf using its entry in Commands. The rest of
+   the header is read in one transfer once the command byte is known, then
+   the payload is checked against the buffer sizes and read if it is an input. 
+   Returns the frame layout and the length of the request read, or NULL if 
+   the command is invalid. */
+static const CommandFrame *parseCommand(size_t *requestLen) {
     uint32_t nLen;
-    int validCmd = 1;
+    uint8_t cmd;
+
     Transport_getData(RxBuf, 1); 
-    idx++;
+    cmd = RxBuf[0];
 
-    enum OpenEEPROM_Command cmd;
-    memcpy(&cmd, RxBuf, sizeof(cmd));
+    if (cmd >= COMMAND_COUNT || Commands[cmd].handler == NULL) {
+        return NULL;
+    }
 
+    const CommandFrame *frame = &Commands[cmd];
+    if (frame->headerLen > 1) {
+        Transport_getData(&RxBuf[1], frame->headerLen - 1);
+    }
+
+    *requestLen = frame->headerLen;
+    if (frame->payload == FRAME_PAYLOAD_NONE) {
+        return frame;
+    }
+
+    memcpy(&nLen, &RxBuf[frame->lenOffset], sizeof(nLen));
+
+    /* Account for the header already inside the arena and the status byte of
+       the response. In-place responses end where the request does, so only 
+       the request size limits them. */
+    if (frame->payload != FRAME_PAYLOAD_OUT && nLen > (RxBufSize - frame->headerLen) / frame->unit) {
+        return NULL;
+    }
+    if (frame->payload == FRAME_PAYLOAD_OUT && nLen > (TxBufSize - 1) / frame->unit) {
+        return NULL;
+    }
+
+    if (frame->payload != FRAME_PAYLOAD_OUT) {
+        Transport_getData(&RxBuf[frame->headerLen], nLen * frame->unit);
+        *requestLen += nLen * frame->unit;
+    }
+
+    /* Extent data travels after the extent list, either following it in 
+       the request or after the response status, which itself follows 
+       the request in the arena. */
+    if (frame->payload == FRAME_PAYLOAD_GATHER || frame->payload == FRAME_PAYLOAD_SCATTER) {
+        size_t total, limit;
+        if (frame->payload == FRAME_PAYLOAD_GATHER) {
+            size_t arenaLeft = RxBufSize + OPEN_EEPROM_FRAME_RESERVE - *requestLen - 1;
+            limit = arenaLeft < TxBufSize - 1 ? arenaLeft : TxBufSize - 1;
+        } else {
+            limit = RxBufSize - *requestLen;
+        }
+        if (!extentsFit(&RxBuf[frame->headerLen], nLen, limit, &total)) {
+            return NULL;
+        }
+        if (frame->payload == FRAME_PAYLOAD_SCATTER) {
+            Transport_getData(&RxBuf[*requestLen], total);
+            *requestLen += total;
+        }
+    }
+
+    return frame;
+}
+
+/* Sum the lengths of a list of extents, failing if it exceeds limit. */
+static int extentsFit(const char *extents, uint32_t count, size_t limit, size_t *total) {
+    uint32_t length;
+
+    *total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(&length, &extents[i * EXTENT_SIZE + sizeof(uint32_t)], sizeof(length));
+        if (length > limit - *total) {
+            return 0;
+        }
+        *total += length;
+    }
+    return 1;
+}
+
+/* While a job runs, the buses belong to it. */
+static int allowedDuringJob(uint8_t cmd) {
     switch (cmd) {
         case OPEN_EEPROM_CMD_NOP:
         case OPEN_EEPROM_CMD_SYNC:
@@ -193,73 +360,11 @@ static int parseCommand(void) {
         case OPEN_EEPROM_CMD_GET_MAX_TX_SIZE:
         case OPEN_EEPROM_CMD_GET_SUPPORTED_BUS_TYPES:
         case OPEN_EEPROM_CMD_GET_SUPPORTED_SPI_MODES:
-            break;
-
-        case OPEN_EEPROM_CMD_TOGGLE_IO:
-        case OPEN_EEPROM_CMD_SET_ADDRESS_BUS_WIDTH:
-        case OPEN_EEPROM_CMD_SET_SPI_MODE:
-            Transport_getData(&RxBuf[idx], 1);
-            idx++;
-            break;
-        
-        case OPEN_EEPROM_CMD_SET_ADDRESS_HOLD_TIME:
-        case OPEN_EEPROM_CMD_SET_PULSE_WIDTH_TIME:
-        case OPEN_EEPROM_CMD_SET_SPI_CLOCK_FREQ:
-            Transport_getData(&RxBuf[idx], 4);
-            idx += 4;  
-            break;
-
-        case OPEN_EEPROM_CMD_PARALLEL_WRITE:   
-            Transport_getData(&RxBuf[idx], 4);
-            idx += 4;
-            Transport_getData(&RxBuf[idx], 4);
-            memcpy(&nLen, &RxBuf[idx], sizeof(nLen));
-            idx += 4;
-            
-            // Account for the 9 bytes already inside the buffer.
-            if (nLen + 9 > RxBufSize) {
-                validCmd = 0;
-            } else {
-                Transport_getData(&RxBuf[idx], nLen);
-                idx += nLen;
-            }
-
-            break;
-
-        case OPEN_EEPROM_CMD_PARALLEL_READ:   
-            Transport_getData(&RxBuf[idx], 4);
-            idx += 4;
-            Transport_getData(&RxBuf[idx], 4);
-            memcpy(&nLen, &RxBuf[idx], sizeof(nLen));
-            idx += 4;
-
-            // Account for the status byte inside the buffer.
-            if (nLen + 1 > TxBufSize) {
-                validCmd = 0;
-            }
-            
-            break;
-
-        case OPEN_EEPROM_CMD_SPI_TRANSMIT:
-            Transport_getData(&RxBuf[idx], 4);
-            memcpy(&nLen, &RxBuf[idx], sizeof(nLen));
-            idx += 4;
-            
-            /* In addition to the n bytes represented by nLen, the RxBuf will already contain
-               the 1-byte command and 4-byte nLen, and the TxBuf will contain the command status ACK/NAK. */
-            if (nLen + 5  > RxBufSize || nLen + 1 > TxBufSize) {
-                validCmd = 0;
-            } else {
-                Transport_getData(&RxBuf[idx], nLen);
-            }
-
-            break;
-
+        case OPEN_EEPROM_CMD_LIST_PROFILES:
+        case OPEN_EEPROM_CMD_JOB_STATUS:
+        case OPEN_EEPROM_CMD_JOB_ABORT:
+            return 1;
         default:
-            validCmd = 0;
-            break;
+            return 0;
     }
-    
-    return validCmd;
 }
-
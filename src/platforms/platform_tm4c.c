@@ -11,19 +11,64 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "platforms/tm4c/driverlib/hw_memmap.h"
+#include "platforms/tm4c/driverlib/hw_types.h"
+#include "platforms/tm4c/driverlib/hw_gpio.h"
+#include "platforms/tm4c/driverlib/hw_ssi.h"
+#include "platforms/tm4c/driverlib/hw_nvic.h"
 #include "platforms/tm4c/driverlib/sysctl.h"
 #include "platforms/tm4c/driverlib/gpio.h"
 #include "platforms/tm4c/driverlib/ssi.h"
+#include "platforms/tm4c/driverlib/i2c.h"
 #include "platforms/tm4c/driverlib/uart.h"
+#include "platforms/tm4c/driverlib/sw_crc.h"
+#include "platforms/tm4c/driverlib/eeprom.h"
+#include "platforms/tm4c/driverlib/timer.h"
+#include "platforms/tm4c/driverlib/flash.h"
+#include "string.h"
 #include "programmer.h"
+#include "open-eeprom.h"
 #include "transport.h"
 
 #define PART_TM4C123GH6PM
 #include "platforms/tm4c/driverlib/pin_map.h"
 
-#define MAX_DATA_WIDTH 8
+#define MAX_DATA_WIDTH 16
+
+/* The address extender shifts the upper address bits into two 74HC595s
+   over SSI3. Its TX pin is A13, leaving 13 native address lines. */
+#define EXTENDER_ADDRESS_WIDTH 16
+#define EXTENDER_NATIVE_WIDTH 13
+#define EXTENDER_CLOCK_FREQ 10000000
 #define MAX_ADDRESS_WIDTH 15
 
+/* 
+ * Bus loops run from zero-wait-state SRAM, see the .ramfunc 
+ * section in the linker script. They access the GPIO and SSI 
+ * registers directly rather than calling into driverlib in flash.
+ */
+#define RAMFUNC __attribute__((section(".ramfunc"), long_call, noinline))
+
+/* Masked access to the GPIO data register: only `pins` are affected. */
+#define GPIO_DATA(port, pins) HWREG((port) + GPIO_O_DATA + ((uint32_t) (pins) << 2))
+
+/* Cycle counter of the Data Watchpoint and Trace unit, used for deadlines. */
+#define DEMCR_TRCENA        0x01000000
+#define DWT_CTRL            HWREG(0xE0001000)
+#define DWT_CTRL_CYCCNTENA  0x00000001
+#define DWT_CYCCNT          HWREG(0xE0001004)
+
+/* GPIO ports A-F, in the order of the APB apertures. */
+#define PORT_COUNT 6
+#define PORT_INDEX(port) ((port) < GPIO_PORTE_BASE ? \
+        ((port) - GPIO_PORTA_BASE) >> 12 : 4 + (((port) - GPIO_PORTE_BASE) >> 12))
+
+/* Flash is erased in 1 KB blocks. */
+#define FLASH_BLOCK_SIZE 1024
+
+/* Image store placed by the linker script in the upper half of flash. */
+extern char _image[];
+extern char _eimage[];
+
 /**
  * @struct
  * Representation of a GPIO pin on the TM4C MCU.
@@ -45,6 +90,25 @@ typedef struct {
     DriverLibGpioPin TX;
 } DriverLibSpiModule;
 
+/**
+ * @struct 
+ * Representation of an I2C peripheral on the TM4C MCU.
+ */
+typedef struct {
+    DriverLibGpioPin SCL;
+    DriverLibGpioPin SDA;
+} DriverLibI2cModule;
+
+/**
+ * @struct 
+ * Representation of the shift register address extender.
+ */
+typedef struct {
+    DriverLibGpioPin CLK;
+    DriverLibGpioPin TX;
+    DriverLibGpioPin LATCH;
+} DriverLibAddressExtender;
+
 /**
  * @struct 
  * Representation of a TM4C programmer.
@@ -59,7 +123,11 @@ typedef struct {
     DriverLibGpioPin WEn;
     DriverLibGpioPin OEn;
     DriverLibGpioPin CEn;
+    DriverLibGpioPin VPP;
+    DriverLibGpioPin TRIGGER;
     DriverLibSpiModule spi;
+    DriverLibI2cModule i2c;
+    DriverLibAddressExtender extender;
 } DriverLibProgrammer;
 
 static DriverLibProgrammer Progr = {
@@ -97,22 +165,66 @@ static DriverLibProgrammer Progr = {
         {GPIO_PORTC_BASE, GPIO_PIN_4},
         {GPIO_PORTE_BASE, GPIO_PIN_0},
         {GPIO_PORTB_BASE, GPIO_PIN_2},
-
+        /* D15:D8 for word-wide parts, D8 is shared with I2C SDA */
+        {GPIO_PORTB_BASE, GPIO_PIN_3},
+        {GPIO_PORTC_BASE, GPIO_PIN_6},
+        {GPIO_PORTD_BASE, GPIO_PIN_4},
+        {GPIO_PORTD_BASE, GPIO_PIN_5},
+        {GPIO_PORTD_BASE, GPIO_PIN_7},
+        {GPIO_PORTF_BASE, GPIO_PIN_0},
+        {GPIO_PORTF_BASE, GPIO_PIN_2},
+        {GPIO_PORTF_BASE, GPIO_PIN_3},
     },
     .CEn = {GPIO_PORTA_BASE, GPIO_PIN_2},
     .OEn = {GPIO_PORTD_BASE, GPIO_PIN_6},
     .WEn = {GPIO_PORTC_BASE, GPIO_PIN_7},
+    /* Enables the external Vpp switch, active high */
+    .VPP = {GPIO_PORTF_BASE, GPIO_PIN_4},
+    /* SW2 on the LaunchPad, shared with D13 */
+    .TRIGGER = {GPIO_PORTF_BASE, GPIO_PIN_0},
     .spi = {
         .CLK = {GPIO_PORTA_BASE, GPIO_PIN_2},
         .CS = {GPIO_PORTA_BASE, GPIO_PIN_3},
         .RX = {GPIO_PORTA_BASE, GPIO_PIN_4},
         .TX = {GPIO_PORTA_BASE, GPIO_PIN_5}
+    },
+    .i2c = {
+        .SCL = {GPIO_PORTB_BASE, GPIO_PIN_2},
+        .SDA = {GPIO_PORTB_BASE, GPIO_PIN_3}
+    },
+    .extender = {
+        .CLK = {GPIO_PORTD_BASE, GPIO_PIN_0},
+        .TX = {GPIO_PORTD_BASE, GPIO_PIN_3},
+        .LATCH = {GPIO_PORTD_BASE, GPIO_PIN_1}
     }
 };
 
 static DriverLibProgrammer *ProgrPtr = &Progr;
 static uint32_t CurrentSpiMode;
 static uint32_t CurrentSpiFreq;
+static uint32_t PadStrength = GPIO_STRENGTH_2MA;
+static uint8_t DataBusWidth = 8;
+static uint8_t AddressExtenderEnabled;
+static uint32_t Deadline;
+
+/* Port images of a staged parallel write. */
+static const uint32_t PortBases[PORT_COUNT] = {
+    GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTC_BASE, 
+    GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTF_BASE,
+};
+static uint8_t StagedMask[PORT_COUNT];
+static uint8_t StagedImage[PORT_COUNT];
+
+/* Pad drive settings indexed by OpenEEPROM_PadDrive. */
+static const uint32_t PadStrengths[] = {
+    GPIO_STRENGTH_2MA, GPIO_STRENGTH_4MA, GPIO_STRENGTH_8MA, GPIO_STRENGTH_8MA_SC,
+};
+
+/* Like GPIOPinTypeGPIOOutput, but with the selected drive strength. */
+static void padTypeOutput(uint32_t port, uint8_t pin) {
+    GPIOPadConfigSet(port, pin, PadStrength, GPIO_PIN_TYPE_STD);
+    GPIODirModeSet(port, pin, GPIO_DIR_MODE_OUT);
+}
 
 /* 
  * The TM4C has a max clock speed of 80 MHz,
@@ -120,6 +232,10 @@ static uint32_t CurrentSpiFreq;
  */
 const uint32_t Programmer_MinimumDelay = 13;
 
+/* Wide timer 0A counts down from the system clock through
+   its prescaler, see Programmer_getTicks. */
+const uint32_t Programmer_TicksPerSecond = 10000;
+
 int Programmer_init(void) {
     SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
 
@@ -128,22 +244,66 @@ int Programmer_init(void) {
         while (!SysCtlPeripheralReady(*port))
             ;
     }
+
+    /* PD7 and PF0 are NMI and boot pins, locked until committed as GPIO. */
+    GPIOUnlockPin(GPIO_PORTD_BASE, GPIO_PIN_7);
+    GPIOUnlockPin(GPIO_PORTF_BASE, GPIO_PIN_0);
+
+    GPIOPinTypeGPIOOutput(ProgrPtr->VPP.port, ProgrPtr->VPP.pin);
+    GPIOPinWrite(ProgrPtr->VPP.port, ProgrPtr->VPP.pin, 0);
+
+    HWREG(NVIC_DBG_INT) |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_WTIMER0);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_WTIMER0))
+        ;
+    TimerConfigure(WTIMER0_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC);
+    TimerPrescaleSet(WTIMER0_BASE, TIMER_A, SysCtlClockGet() / Programmer_TicksPerSecond - 1);
+    TimerLoadSet(WTIMER0_BASE, TIMER_A, UINT32_MAX);
+    TimerEnable(WTIMER0_BASE, TIMER_A);
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_EEPROM0))
+        ;
+    EEPROMInit();
+
     return 1;
 }
 
 int Programmer_initParallel(void) {
-    GPIOPinTypeGPIOOutput(ProgrPtr->WEn.port, ProgrPtr->WEn.pin);
-    GPIOPinTypeGPIOOutput(ProgrPtr->CEn.port, ProgrPtr->CEn.pin);
-    GPIOPinTypeGPIOOutput(ProgrPtr->OEn.port, ProgrPtr->OEn.pin);
+    padTypeOutput(ProgrPtr->WEn.port, ProgrPtr->WEn.pin);
+    padTypeOutput(ProgrPtr->CEn.port, ProgrPtr->CEn.pin);
+    padTypeOutput(ProgrPtr->OEn.port, ProgrPtr->OEn.pin);
 
     GPIOPinWrite(ProgrPtr->WEn.port, ProgrPtr->WEn.pin, ProgrPtr->WEn.pin);
     GPIOPinWrite(ProgrPtr->CEn.port, ProgrPtr->CEn.pin, ProgrPtr->CEn.pin);
     GPIOPinWrite(ProgrPtr->OEn.port, ProgrPtr->OEn.pin, ProgrPtr->OEn.pin);
 
-    for (int i = 0; i < MAX_ADDRESS_WIDTH; i++ ) {
-        GPIOPinTypeGPIOOutput(ProgrPtr->A[i].port, ProgrPtr->A[i].pin);
+    int nativeWidth = AddressExtenderEnabled ? EXTENDER_NATIVE_WIDTH : MAX_ADDRESS_WIDTH;
+    for (int i = 0; i < nativeWidth; i++ ) {
+        padTypeOutput(ProgrPtr->A[i].port, ProgrPtr->A[i].pin);
     }    
 
+    if (AddressExtenderEnabled) {
+        SysCtlPeripheralEnable(SYSCTL_PERIPH_SSI3);
+        while (!SysCtlPeripheralReady(SYSCTL_PERIPH_SSI3))
+            ;
+
+        GPIOPinConfigure(GPIO_PD0_SSI3CLK);
+        GPIOPinConfigure(GPIO_PD3_SSI3TX);
+        GPIOPinTypeSSI(ProgrPtr->extender.CLK.port, ProgrPtr->extender.CLK.pin | ProgrPtr->extender.TX.pin);
+        padTypeOutput(ProgrPtr->extender.LATCH.port, ProgrPtr->extender.LATCH.pin);
+        GPIO_DATA(ProgrPtr->extender.LATCH.port, ProgrPtr->extender.LATCH.pin) = 0;
+
+        /* One 16-bit frame fills both registers, MSB first. */
+        SSIDisable(SSI3_BASE);
+        SSIConfigSetExpClk(SSI3_BASE, SysCtlClockGet(), SSI_FRF_MOTO_MODE_0,
+                SSI_MODE_MASTER, EXTENDER_CLOCK_FREQ, EXTENDER_ADDRESS_WIDTH);
+        SSIEnable(SSI3_BASE);
+    }
+
     return 1;
 }
 
@@ -180,8 +340,26 @@ int Programmer_initSpi(void) {
     return 1;
 }
 
+int Programmer_initI2c(void) {
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_I2C0);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_I2C0))
+        ;
+
+    GPIOPinConfigure(GPIO_PB2_I2C0SCL);
+    GPIOPinConfigure(GPIO_PB3_I2C0SDA);
+
+    GPIOPinTypeI2CSCL(ProgrPtr->i2c.SCL.port, ProgrPtr->i2c.SCL.pin);
+    GPIOPinTypeI2C(ProgrPtr->i2c.SDA.port, ProgrPtr->i2c.SDA.pin);
+
+    /* Standard mode (100 kHz) is supported by every 24-series part. */
+    I2CMasterInitExpClk(I2C0_BASE, SysCtlClockGet(), false);
+
+    return 1;
+}
+
 // TODO: confirm that this disables peripheral
 int Programmer_disableIOPins(void) {
+    GPIOPinWrite(ProgrPtr->VPP.port, ProgrPtr->VPP.pin, 0);
     for (uint32_t *port = ProgrPtr->ports; *port != 0; port++) {
         SysCtlPeripheralDisable(*port);
     }
@@ -190,56 +368,102 @@ int Programmer_disableIOPins(void) {
 
 int Programmer_toggleDataIOMode(uint8_t mode) {
     if (mode == 0) {
-        for (int i = 0; i < MAX_DATA_WIDTH; i++) {
+        for (int i = 0; i < DataBusWidth; i++) {
             GPIOPinTypeGPIOInput(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin);
         }
     } else {
-        for (int i = 0; i < MAX_DATA_WIDTH; i++) {
-            GPIOPinTypeGPIOOutput(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin);
+        for (int i = 0; i < DataBusWidth; i++) {
+            padTypeOutput(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin);
         }
     }
     return 1;
 }
 
+int Programmer_getAddressExtenderWidth(void) {
+    return EXTENDER_ADDRESS_WIDTH;
+}
+
+int Programmer_setAddressExtender(uint8_t enable) {
+    AddressExtenderEnabled = enable != 0;
+    return AddressExtenderEnabled ? EXTENDER_NATIVE_WIDTH : MAX_ADDRESS_WIDTH;
+}
+
+/* Wait for the frame to leave the shift register before latching it. */
+RAMFUNC int Programmer_setUpperAddress(uint32_t address) {
+    while (!(HWREG(SSI3_BASE + SSI_O_SR) & SSI_SR_TNF))
+        ;
+    HWREG(SSI3_BASE + SSI_O_DR) = address & 0xFFFF;
+    while (HWREG(SSI3_BASE + SSI_O_SR) & SSI_SR_BSY)
+        ;
+    GPIO_DATA(ProgrPtr->extender.LATCH.port, ProgrPtr->extender.LATCH.pin) = ProgrPtr->extender.LATCH.pin;
+    GPIO_DATA(ProgrPtr->extender.LATCH.port, ProgrPtr->extender.LATCH.pin) = 0;
+    return 1;
+}
+
+int Programmer_getDataPinCount(void) {
+    return sizeof(ProgrPtr->IO) / sizeof(ProgrPtr->IO[0]);
+}
+
+int Programmer_setDataBusWidth(uint8_t busWidth) {
+    if (busWidth != 8 && busWidth != MAX_DATA_WIDTH) {
+        return 0;
+    }
+    for (int i = busWidth; i < MAX_DATA_WIDTH; i++) {
+        GPIOPinTypeGPIOInput(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin);
+    }
+    DataBusWidth = busWidth;
+    return 1;
+}
+
 int Programmer_getAddressPinCount(void) {
     return sizeof(ProgrPtr->A) / sizeof(ProgrPtr->A[0]);
 }
 
-int Programmer_setAddress(uint8_t busWidth, uint32_t address) {
+RAMFUNC int Programmer_setAddress(uint8_t busWidth, uint32_t address) {
     for (int i = 0; i < busWidth; i++) {
-        GPIOPinWrite(ProgrPtr->A[i].port, ProgrPtr->A[i].pin, address & 1 ? ProgrPtr->A[i].pin : 0);
+        GPIO_DATA(ProgrPtr->A[i].port, ProgrPtr->A[i].pin) = address & 1 ? ProgrPtr->A[i].pin : 0;
         address >>= 1;
     }
     return 1;
 }
 
-int Programmer_setData(uint8_t value) {
-    for (int i = 0; i < MAX_DATA_WIDTH; i++) {
-        GPIOPinWrite(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin, (value & 1) ? ProgrPtr->IO[i].pin : 0);
+RAMFUNC int Programmer_setData(uint16_t value) {
+    for (int i = 0; i < DataBusWidth; i++) {
+        GPIO_DATA(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin) = (value & 1) ? ProgrPtr->IO[i].pin : 0;
         value >>= 1;
     }
     return 1;
 }
 
-int Programmer_toggleCE(uint8_t state) {
-    GPIOPinWrite(ProgrPtr->CEn.port, ProgrPtr->CEn.pin, state == 0 ? 0 : ProgrPtr->CEn.pin); 
+RAMFUNC int Programmer_toggleCE(uint8_t state) {
+    GPIO_DATA(ProgrPtr->CEn.port, ProgrPtr->CEn.pin) = state == 0 ? 0 : ProgrPtr->CEn.pin; 
     return 1;
 }
 
-int Programmer_toggleOE(uint8_t state) {
-    GPIOPinWrite(ProgrPtr->OEn.port, ProgrPtr->OEn.pin, state == 0 ? 0 : ProgrPtr->OEn.pin); 
+RAMFUNC int Programmer_toggleOE(uint8_t state) {
+    GPIO_DATA(ProgrPtr->OEn.port, ProgrPtr->OEn.pin) = state == 0 ? 0 : ProgrPtr->OEn.pin; 
     return 1;
 }
 
-int Programmer_toggleWE(uint8_t state) {
-    GPIOPinWrite(ProgrPtr->WEn.port, ProgrPtr->WEn.pin, state == 0 ? 0 : ProgrPtr->WEn.pin); 
+RAMFUNC int Programmer_toggleWE(uint8_t state) {
+    GPIO_DATA(ProgrPtr->WEn.port, ProgrPtr->WEn.pin) = state == 0 ? 0 : ProgrPtr->WEn.pin; 
     return 1;
 }
 
-uint8_t Programmer_getData(void) {
-    uint8_t data = 0;
-    for (int i = 0; i < MAX_DATA_WIDTH; i++) {
-        data |= (GPIOPinRead(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin) ? 1 : 0) << i;
+/* Sockets wire PGM# of larger EPROMs where flash and EEPROM parts have WE#. */
+int Programmer_togglePGM(uint8_t state) {
+    return Programmer_toggleWE(state);
+}
+
+int Programmer_setVpp(uint8_t enable) {
+    GPIOPinWrite(ProgrPtr->VPP.port, ProgrPtr->VPP.pin, enable ? ProgrPtr->VPP.pin : 0);
+    return 1;
+}
+
+RAMFUNC uint16_t Programmer_getData(void) {
+    uint16_t data = 0;
+    for (int i = 0; i < DataBusWidth; i++) {
+        data |= (GPIO_DATA(ProgrPtr->IO[i].port, ProgrPtr->IO[i].pin) ? 1 : 0) << i;
     }
     return data;
 }
@@ -260,6 +484,50 @@ int Programmer_delay1ns(uint32_t delay) {
     }
 }
 
+/* The timer counts down, so its complement counts up. */
+uint32_t Programmer_getTicks(void) {
+    return ~TimerValueGet(WTIMER0_BASE, TIMER_A);
+}
+
+/* Same rounding as Programmer_delay1ns, 12.5ns per cycle. The deadline
+   is compared as a signed difference so counter wrap-around is harmless. */
+RAMFUNC void Programmer_startDelay(uint32_t delay) {
+    Deadline = DWT_CYCCNT + ((delay * 10) + 124) / 125;
+}
+
+RAMFUNC void Programmer_waitDelay(void) {
+    while ((int32_t) (DWT_CYCCNT - Deadline) < 0)
+        ;
+}
+
+RAMFUNC void Programmer_stageWrite(uint8_t busWidth, uint32_t address, uint16_t data) {
+    for (int p = 0; p < PORT_COUNT; p++) {
+        StagedMask[p] = 0;
+        StagedImage[p] = 0;
+    }
+    for (int i = 0; i < busWidth; i++) {
+        int p = PORT_INDEX(ProgrPtr->A[i].port);
+        StagedMask[p] |= ProgrPtr->A[i].pin;
+        StagedImage[p] |= address & 1 ? ProgrPtr->A[i].pin : 0;
+        address >>= 1;
+    }
+    for (int i = 0; i < DataBusWidth; i++) {
+        int p = PORT_INDEX(ProgrPtr->IO[i].port);
+        StagedMask[p] |= ProgrPtr->IO[i].pin;
+        StagedImage[p] |= data & 1 ? ProgrPtr->IO[i].pin : 0;
+        data >>= 1;
+    }
+}
+
+/* One masked store per port instead of one per pin. */
+RAMFUNC void Programmer_commitWrite(void) {
+    for (int p = 0; p < PORT_COUNT; p++) {
+        if (StagedMask[p] != 0) {
+            GPIO_DATA(PortBases[p], StagedMask[p]) = StagedImage[p];
+        }
+    }
+}
+
 int Programmer_enableChip(void) {
     return 1;
 }
@@ -273,9 +541,26 @@ int Programmer_setSpiClockFreq(uint32_t freq) {
     return 1;
 }
 
+/* The SSI frame formats number the modes by polarity and phase bits 
+   in the opposite order to the usual SPI mode numbers. */
 int Programmer_setSpiMode(uint8_t mode) {
+    switch (mode) {
+        case OPEN_EEPROM_SPI_MODE_0:
+            CurrentSpiMode = SSI_FRF_MOTO_MODE_0;
+            break;
+        case OPEN_EEPROM_SPI_MODE_1:
+            CurrentSpiMode = SSI_FRF_MOTO_MODE_1;
+            break;
+        case OPEN_EEPROM_SPI_MODE_2:
+            CurrentSpiMode = SSI_FRF_MOTO_MODE_2;
+            break;
+        case OPEN_EEPROM_SPI_MODE_3:
+            CurrentSpiMode = SSI_FRF_MOTO_MODE_3;
+            break;
+        default:
+            return 0;
+    }
     SSIDisable(SSI0_BASE);
-    CurrentSpiMode = mode;
     SSIConfigSetExpClk(SSI0_BASE, SysCtlClockGet(), CurrentSpiMode, 
             SSI_MODE_MASTER, CurrentSpiFreq, 8);
     SSIEnable(SSI0_BASE);
@@ -283,21 +568,159 @@ int Programmer_setSpiMode(uint8_t mode) {
 }
 
 uint8_t Programmer_getSupportedSpiModes(void) {
-    return 0;
+    return OPEN_EEPROM_SPI_MODE_0 | OPEN_EEPROM_SPI_MODE_1 | OPEN_EEPROM_SPI_MODE_2 | OPEN_EEPROM_SPI_MODE_3;
 }
 
-int Programmer_spiTransmit(const char *txbuf, char *rxbuf, size_t count) {
-    uint32_t readVal;
-    GPIOPinWrite(ProgrPtr->spi.CS.port, ProgrPtr->spi.CS.pin, 0);
+RAMFUNC int Programmer_spiTransmit(const char *txbuf, char *rxbuf, size_t count) {
+    GPIO_DATA(ProgrPtr->spi.CS.port, ProgrPtr->spi.CS.pin) = 0;
+    /* txbuf[i] is consumed before rxbuf[i] is written, so this also works in place. */
     for (size_t i = 0; i < count; i++) {
-        SSIDataPut(SSI0_BASE, txbuf[i]);
-        SSIDataGet(SSI0_BASE, &readVal);
-        rxbuf[i] = (char) readVal;
+        while (!(HWREG(SSI0_BASE + SSI_O_SR) & SSI_SR_TNF))
+            ;
+        HWREG(SSI0_BASE + SSI_O_DR) = (uint8_t) txbuf[i];
+        while (!(HWREG(SSI0_BASE + SSI_O_SR) & SSI_SR_RNE))
+            ;
+        rxbuf[i] = (char) HWREG(SSI0_BASE + SSI_O_DR);
+    }
+    GPIO_DATA(ProgrPtr->spi.CS.port, ProgrPtr->spi.CS.pin) = ProgrPtr->spi.CS.pin;
+    return 1;
+}
+
+static int i2cRunCommand(uint32_t cmd) {
+    I2CMasterControl(I2C0_BASE, cmd);
+    while (!I2CMasterBusy(I2C0_BASE))
+        ;
+    while (I2CMasterBusy(I2C0_BASE))
+        ;
+    return I2CMasterErr(I2C0_BASE) == I2C_MASTER_ERR_NONE;
+}
+
+int Programmer_i2cTransfer(uint8_t address, const char *txbuf, size_t txCount, char *rxbuf, size_t rxCount) {
+    uint32_t cmd;
+
+    if (txCount > 0) {
+        I2CMasterSlaveAddrSet(I2C0_BASE, address, false);
+        for (size_t i = 0; i < txCount; i++) {
+            if (i == 0) {
+                cmd = (txCount == 1 && rxCount == 0) ? I2C_MASTER_CMD_SINGLE_SEND : I2C_MASTER_CMD_BURST_SEND_START;
+            } else if (i == txCount - 1 && rxCount == 0) {
+                cmd = I2C_MASTER_CMD_BURST_SEND_FINISH;
+            } else {
+                cmd = I2C_MASTER_CMD_BURST_SEND_CONT;
+            }
+
+            I2CMasterDataPut(I2C0_BASE, txbuf[i]);
+            if (!i2cRunCommand(cmd)) {
+                I2CMasterControl(I2C0_BASE, I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+                return 0;
+            }
+        }
+    }
+
+    if (rxCount > 0) {
+        I2CMasterSlaveAddrSet(I2C0_BASE, address, true);
+        for (size_t i = 0; i < rxCount; i++) {
+            if (i == 0) {
+                cmd = rxCount == 1 ? I2C_MASTER_CMD_SINGLE_RECEIVE : I2C_MASTER_CMD_BURST_RECEIVE_START;
+            } else if (i == rxCount - 1) {
+                cmd = I2C_MASTER_CMD_BURST_RECEIVE_FINISH;
+            } else {
+                cmd = I2C_MASTER_CMD_BURST_RECEIVE_CONT;
+            }
+
+            if (!i2cRunCommand(cmd)) {
+                I2CMasterControl(I2C0_BASE, I2C_MASTER_CMD_BURST_RECEIVE_ERROR_STOP);
+                return 0;
+            }
+            rxbuf[i] = (char) I2CMasterDataGet(I2C0_BASE);
+        }
+    }
+
+    return 1;
+}
+
+/* Takes effect the next time the parallel pins are made outputs. */
+int Programmer_setPadDrive(uint8_t drive) {
+    if (drive >= sizeof(PadStrengths) / sizeof(PadStrengths[0])) {
+        return 0;
+    }
+    PadStrength = PadStrengths[drive];
+    return 1;
+}
+
+/* Storage is the on-chip EEPROM, which is accessed in 32-bit words. */
+uint32_t Programmer_getStorageSize(void) {
+    return EEPROMSizeGet();
+}
+
+int Programmer_readStorage(uint32_t offset, char *buf, size_t count) {
+    if ((offset | count) & 3 || ((uint32_t) buf & 3) || offset + count > EEPROMSizeGet()) {
+        return 0;
+    }
+    EEPROMRead((uint32_t *) buf, offset, count);
+    return 1;
+}
+
+int Programmer_writeStorage(uint32_t offset, const char *buf, size_t count) {
+    if ((offset | count) & 3 || ((uint32_t) buf & 3) || offset + count > EEPROMSizeGet()) {
+        return 0;
+    }
+    return EEPROMProgram((uint32_t *) buf, offset, count) == 0;
+}
+
+uint32_t Programmer_getImageStoreSize(void) {
+    return _eimage - _image;
+}
+
+int Programmer_eraseImageStore(void) {
+    for (char *block = _image; block < _eimage; block += FLASH_BLOCK_SIZE) {
+        if (FlashErase((uint32_t) block) != 0) {
+            return 0;
+        }
     }
-    GPIOPinWrite(ProgrPtr->spi.CS.port, ProgrPtr->spi.CS.pin, ProgrPtr->spi.CS.pin);
     return 1;
 }
 
+/* The image store is memory mapped, so it reads like any other memory. */
+int Programmer_readImageStore(uint32_t offset, char *buf, size_t count) {
+    if (offset + count > Programmer_getImageStoreSize()) {
+        return 0;
+    }
+    memcpy(buf, &_image[offset], count);
+    return 1;
+}
+
+int Programmer_writeImageStore(uint32_t offset, const char *buf, size_t count) {
+    if ((offset | count) & 3 || ((uint32_t) buf & 3) || offset + count > Programmer_getImageStoreSize()) {
+        return 0;
+    }
+    return FlashProgram((uint32_t *) buf, (uint32_t) &_image[offset], count) == 0;
+}
+
+/* SPI CLK, CS and TX double as CE#, D0 and A6, and I2C SCL and SDA 
+   as D7 and D8, so only SPI and I2C can be used together. */
+int Programmer_busesIndependent(uint8_t busA, uint8_t busB) {
+    return (busA | busB) == (OPEN_EEPROM_BUS_MODE_SPI | OPEN_EEPROM_BUS_MODE_I2C);
+}
+
+/* The button pulls PF0 low. It is only free while D13 is unused. */
+int Programmer_getTrigger(void) {
+    if (DataBusWidth != 8) {
+        return 0;
+    }
+    GPIOPinTypeGPIOInput(ProgrPtr->TRIGGER.port, ProgrPtr->TRIGGER.pin);
+    GPIOPadConfigSet(ProgrPtr->TRIGGER.port, ProgrPtr->TRIGGER.pin, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
+    return GPIO_DATA(ProgrPtr->TRIGGER.port, ProgrPtr->TRIGGER.pin) == 0;
+}
+
+uint32_t Programmer_crc32(uint32_t crc, const char *buf, size_t count) {
+    return Crc32(crc, (const uint8_t *) buf, count);
+}
+
+uint16_t Programmer_crc16(uint16_t crc, const char *buf, size_t count) {
+    return Crc16(crc, (const uint8_t *) buf, count);
+}
+
 int Transport_init(void) {
     SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);